@@ -0,0 +1,127 @@
+#include "maths/Algebra.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+//	TransformBench
+//
+//	Times building the corners of 'k_Count' quads and cubes three ways: the scalar glm path of a
+//	full transform matrix applied to each corner, the per entity 'MakeQuadVertices' and
+//	'MakeCubeVertices' and their batch variants. Reports the best of 'k_Runs' runs of each and the
+//	largest difference between the batch and glm corners.
+//-------------------------------------------------------------------------------------------------
+static constexpr size_t k_Count = 100 * 1000;
+static constexpr size_t k_Runs = 20;
+
+// Same corner order as the vertex helpers.
+static const glm::vec3 k_UnitQuad[4] = {
+	{ -1.0f, -1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }
+};
+static const glm::vec3 k_UnitCube[8] = {
+	{ -1.0f, -1.0f, 1.0f }, { -1.0f, 1.0f, 1.0f }, { 1.0f, -1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f },
+	{ -1.0f, -1.0f, -1.0f }, { -1.0f, 1.0f, -1.0f }, { 1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, -1.0f }
+};
+
+struct Entities
+{
+	std::vector<glm::vec3> Positions, Scales, Rotations;
+};
+
+// Best time in milliseconds of 'k_Runs' calls of 'func'.
+template<typename Func>
+static double Time(const Func &func)
+{
+	double best = 1e9;
+	for (size_t run = 0; run < k_Runs; ++run)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		func();
+		auto end = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - begin).count());
+	}
+	return best;
+}
+
+static float MaxDifference(const std::vector<glm::vec3> &a, const std::vector<glm::vec3> &b)
+{
+	float difference = 0.0f;
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		glm::vec3 delta = glm::abs(a[i] - b[i]);
+		difference = std::max(difference, std::max(delta.x, std::max(delta.y, delta.z)));
+	}
+	return difference;
+}
+
+template<size_t N>
+static void Bench(const char *name, const Entities &entities, const glm::vec3 (&unit)[N])
+{
+	std::vector<glm::vec3> reference(k_Count * N), single(k_Count * N), batch(k_Count * N);
+
+	double glmTime = Time([&]() {
+		for (size_t i = 0; i < k_Count; ++i)
+		{
+			glm::mat4 transform = MakeTransform(entities.Positions[i], entities.Scales[i], entities.Rotations[i]);
+			for (size_t corner = 0; corner < N; ++corner)
+			{
+				reference[i * N + corner] = glm::vec3(transform * glm::vec4(unit[corner], 1.0f));
+			}
+		}
+	});
+
+	double singleTime = Time([&]() {
+		for (size_t i = 0; i < k_Count; ++i)
+		{
+			if constexpr (N == 4)
+			{
+				auto vertices = MakeQuadVertices(entities.Positions[i], entities.Scales[i], entities.Rotations[i]);
+				std::copy(vertices.begin(), vertices.end(), single.begin() + i * N);
+			}
+			else
+			{
+				auto vertices = MakeCubeVertices(entities.Positions[i], entities.Scales[i], entities.Rotations[i]);
+				std::copy(vertices.begin(), vertices.end(), single.begin() + i * N);
+			}
+		}
+	});
+
+	double batchTime = Time([&]() {
+		if constexpr (N == 4)
+		{
+			MakeQuadVertices(entities.Positions.data(), entities.Scales.data(), entities.Rotations.data(), k_Count, batch.data());
+		}
+		else
+		{
+			MakeCubeVertices(entities.Positions.data(), entities.Scales.data(), entities.Rotations.data(), k_Count, batch.data());
+		}
+	});
+
+	printf("%s: glm %.2f ms, single %.2f ms, batch %.2f ms, max difference %g\n",
+		name, glmTime, singleTime, batchTime, MaxDifference(reference, batch));
+}
+
+int main()
+{
+	std::mt19937 engine(1234);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> scale(0.1f, 2.0f);
+	std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+
+	Entities entities;
+	for (size_t i = 0; i < k_Count; ++i)
+	{
+		entities.Positions.push_back({ position(engine), position(engine), position(engine) });
+		entities.Scales.push_back({ scale(engine), scale(engine), scale(engine) });
+		entities.Rotations.push_back({ angle(engine), angle(engine), angle(engine) });
+	}
+
+	printf("%zu entities, SSE %d, AVX %d\n", k_Count, SIMD_SSE, SIMD_AVX);
+	Bench("Quads", entities, k_UnitQuad);
+	Bench("Cubes", entities, k_UnitCube);
+	return 0;
+}
@@ -1,7 +1,10 @@
-#pragma once
-
-#define ENABLE_LOGGING    1
-#define ENABLE_ASSERTIONS 1
-
-#define k_TimeStep 1.0 / 60.0
-#define k_MaxComponents 2 << 5
\ No newline at end of file
+#pragma once
+
+#define ENABLE_LOGGING    1
+#define ENABLE_ASSERTIONS 1
+#define ENABLE_SIMD       1
+// 20 byte batch vertices with packed normals and colours, instead of 40 bytes of floats.
+#define ENABLE_COMPACT_VERTICES 1
+
+#define k_TimeStep 1.0 / 60.0
+#define k_MaxComponents (2 << 5)
\ No newline at end of file
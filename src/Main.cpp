@@ -1,11 +1,11 @@
-#include "app/App.hpp"
-
-int main()
-{
-	Config config {
-		"Harrax"
-	};
-
-	App::Get()->Run(config);
-	return 0;
-}
+#include "app/App.hpp"
+
+int main()
+{
+	Config config {
+		"Harrax"
+	};
+
+	App::Get()->Run(config);
+	return 0;
+}
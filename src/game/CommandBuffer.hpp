@@ -0,0 +1,247 @@
+#pragma once
+
+#include "game/Registry.hpp"
+#include "util/JobSystem.hpp"
+#include "util/Log.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+//	CommandBuffer
+//
+//	Records structural changes, creating and destroying entities and adding and removing
+//	components, so they can be made from inside views and from worker threads, where changing the
+//	registry directly would invalidate the components being iterated. Each job system thread
+//	records into a buffer of its own without locking, and 'Apply' replays every buffer in one
+//	pass at a sync point, thread by thread and in recording order within each thread.
+//
+//	Entities created through the buffer only exist once applied, until then they are referred to
+//	by the 'PendingEntity' handle 'Create' returns, on the thread which created them.
+//-------------------------------------------------------------------------------------------------
+class CommandBuffer
+{
+	// Records are padded so every one starts suitably aligned for any component.
+	static constexpr size_t k_Alignment = alignof(std::max_align_t);
+	static constexpr uint32_t k_NotPending = ~uint32_t(0);
+
+public:
+	struct PendingEntity
+	{
+		uint32_t Thread;
+		uint32_t Index;
+	};
+
+	// Every possible thread gets a buffer, so command buffers can be created before the job system
+	// is started.
+	CommandBuffer()
+		: m_Buffers(JobSystem::k_MaxThreads)
+	{
+	}
+
+	CommandBuffer(const CommandBuffer &other) = delete;
+	CommandBuffer& operator=(const CommandBuffer &other) = delete;
+
+	// The handle indexes the calling thread's buffer, so it must only be used on that thread and
+	// within the same job. Commands recorded elsewhere could be replayed before the entity exists.
+	PendingEntity Create()
+	{
+		Buffer &buffer = GetBuffer();
+		Push<CreateRecord>(buffer);
+		return { static_cast<uint32_t>(JobSystem::GetThreadIndex()), buffer.PendingCount++ };
+	}
+
+	void Destroy(EntId id)
+	{
+		Push<DestroyRecord>(GetBuffer(), Target{ id, k_NotPending });
+	}
+
+	void Destroy(PendingEntity entity)
+	{
+		Push<DestroyRecord>(GetBuffer(), GetTarget(entity));
+	}
+
+	// The component is built from 'args' now and moved into the registry when applied.
+	template<typename Comp, typename... Args>
+	void AddComponent(EntId id, Args &&...args)
+	{
+		Push<AddRecord<Comp>>(GetBuffer(), Target{ id, k_NotPending }, Comp{ std::forward<Args>(args)... });
+	}
+
+	template<typename Comp, typename... Args>
+	void AddComponent(PendingEntity entity, Args &&...args)
+	{
+		Push<AddRecord<Comp>>(GetBuffer(), GetTarget(entity), Comp{ std::forward<Args>(args)... });
+	}
+
+	template<typename Comp>
+	void RemoveComponent(EntId id)
+	{
+		Push<RemoveRecord<Comp>>(GetBuffer(), Target{ id, k_NotPending });
+	}
+
+	// Replays and clears every thread's commands. Must be called from the main thread while no
+	// view or system is running. Commands on entities destroyed in the meantime are skipped.
+	void Apply()
+	{
+		ASSERT(JobSystem::GetThreadIndex() == 0, "Command buffers can only be applied on the main thread !");
+
+		Registry *reg = Registry::Get();
+		for (auto &buffer : m_Buffers)
+		{
+			buffer.Created.clear();
+			buffer.Created.reserve(buffer.PendingCount);
+
+			uint8_t *data = buffer.Data.data();
+			size_t offset = 0;
+			while (offset < buffer.Data.size())
+			{
+				const Header &header = *reinterpret_cast<const Header *>(data + offset);
+				header.Apply(*reg, data + offset + Align(sizeof(Header)), buffer.Created);
+				offset += header.Size;
+			}
+
+			buffer.Data.clear();
+			buffer.PendingCount = 0;
+		}
+	}
+
+	bool Empty() const
+	{
+		for (const auto &buffer : m_Buffers)
+		{
+			if (!buffer.Data.empty())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	using ApplyFunc = void (*)(Registry &reg, uint8_t *record, std::vector<EntId> &created);
+
+	struct Header
+	{
+		ApplyFunc Apply;
+		size_t Size;
+	};
+
+	// An existing entity, or the index of one created earlier in the same buffer.
+	struct Target
+	{
+		EntId Id;
+		uint32_t Pending;
+
+		EntId Resolve(const std::vector<EntId> &created) const
+		{
+			return Pending == k_NotPending ? Id : created[Pending];
+		}
+	};
+
+	struct CreateRecord
+	{
+		static void Apply(Registry &reg, uint8_t *record, std::vector<EntId> &created)
+		{
+			created.push_back(reg.Create());
+		}
+	};
+
+	struct DestroyRecord
+	{
+		Target Entity;
+
+		static void Apply(Registry &reg, uint8_t *record, std::vector<EntId> &created)
+		{
+			EntId id = reinterpret_cast<DestroyRecord *>(record)->Entity.Resolve(created);
+			if (reg.IsValid(id))
+			{
+				reg.Destroy(id);
+			}
+		}
+	};
+
+	// Records are relocated with memcpy when the buffer grows and never destroyed, as components
+	// are in the pools.
+	template<typename Comp>
+	struct AddRecord
+	{
+		static_assert(std::is_trivially_copyable_v<Comp>, "Only trivially copyable components can be recorded !");
+
+		Target Entity;
+		Comp Component;
+
+		static void Apply(Registry &reg, uint8_t *record, std::vector<EntId> &created)
+		{
+			auto *add = reinterpret_cast<AddRecord *>(record);
+			EntId id = add->Entity.Resolve(created);
+			if (reg.IsValid(id))
+			{
+				reg.AddComponent<Comp>(id, std::move(add->Component));
+			}
+		}
+	};
+
+	template<typename Comp>
+	struct RemoveRecord
+	{
+		Target Entity;
+
+		static void Apply(Registry &reg, uint8_t *record, std::vector<EntId> &created)
+		{
+			EntId id = reinterpret_cast<RemoveRecord *>(record)->Entity.Resolve(created);
+			if (reg.IsValid(id))
+			{
+				reg.RemoveComponent<Comp>(id);
+			}
+		}
+	};
+
+	// Aligned to a cache line so threads appending to their own buffer never share one.
+	struct alignas(64) Buffer
+	{
+		std::vector<uint8_t> Data;
+		std::vector<EntId> Created;
+		uint32_t PendingCount = 0;
+	};
+
+	static constexpr size_t Align(size_t size)
+	{
+		return (size + k_Alignment - 1) & ~(k_Alignment - 1);
+	}
+
+	Buffer &GetBuffer()
+	{
+		size_t thread = JobSystem::GetThreadIndex();
+		ASSERT(thread < m_Buffers.size(), "Recording from a thread the command buffer has no buffer for !");
+		return m_Buffers[thread];
+	}
+
+	Target GetTarget(PendingEntity entity) const
+	{
+		ASSERT(entity.Thread == JobSystem::GetThreadIndex(),
+			"Pending entities can only be used on the thread which created them !");
+		return { k_NullEnt, entity.Index };
+	}
+
+	template<typename Record, typename... Args>
+	void Push(Buffer &buffer, Args &&...args)
+	{
+		static_assert(alignof(Record) <= k_Alignment, "Over aligned components cannot be recorded !");
+
+		size_t offset = buffer.Data.size();
+		size_t size = Align(sizeof(Header)) + Align(sizeof(Record));
+		buffer.Data.resize(offset + size);
+
+		uint8_t *data = buffer.Data.data() + offset;
+		new (data) Header{ &Record::Apply, size };
+		new (data + Align(sizeof(Header))) Record{ std::forward<Args>(args)... };
+	}
+
+private:
+	std::vector<Buffer> m_Buffers;
+};
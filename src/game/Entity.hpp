@@ -1,100 +1,609 @@
-#pragma once
-
-#include "Config.h"
-#include "util/Log.h"
-#include "util/DynamicPool.hpp"
-
-#include <cstdint>
-#include <utility>
-#include <algorithm>
-#include <bitset>
-#include <vector>
-#include <unordered_map>
-#include <tuple>
-
-using EntId = uint32_t;
-using CompId = uint32_t;
-using CompMask = std::bitset<k_MaxComponents>;
-
-template<typename Comp>
-constexpr const char *GetComponentName() { return nullptr; }
-template<typename Comp>
-constexpr uint32_t GetComponentId() { return 0; }
-
-struct Entity
-{
-	EntId Id;
-	CompMask Mask;
-};
-
-class EntityManager
-{
-	friend class Registry;
-	template<typename> friend class ComponentRegisterer;
-
-	using EntityStore = std::vector<Entity>;
-	using CompStore = std::unordered_map<CompId, std::pair<size_t, DynamicPool>>;
-
-private:
-	EntityManager() = default;
-
-	EntId Create()
-	{
-		EntId id = static_cast<EntId>(m_Entities.size());
-		m_Entities.emplace_back();
-		m_Entities[id].Id = id;
-		m_Entities[id].Mask = CompMask();
-		return id;
-	}
-
-	template<typename Comp>
-	bool HasComponent(EntId id)
-	{
-		ASSERT(m_Components.find(GetComponentId<Comp>()) != m_Components.end(),
-			"Attempt to access invalid entities component !");
-		return m_Entities[id].Mask[m_Components[GetComponentId<Comp>()].first];
-	}
-
-	template<typename Comp, typename... Args>
-	void AddComponent(EntId id, Args &&...args)
-	{
-		if (!HasComponent<Comp>(id))
-		{
-			DynamicPool &pool = m_Components[GetComponentId<Comp>()].second;
-			pool.Get<Comp>(id) = Comp{args...};
-			
-			m_Entities[id].Mask.flip(m_Components[GetComponentId<Comp>()].first);
-		}
-	}
-
-	template<typename Comp>
-	Comp &GetComponent(EntId id)
-	{
-		ASSERT(HasComponent<Comp>(id),
-			"Attempt to access invalid entities component !");
-		DynamicPool& pool = m_Components[GetComponentId<Comp>()].second;
-		return pool.Get<Comp>(id);
-	}
-
-	template <typename... Comps>
-	CompMask GetMask()
-	{
-		CompMask mask;
-		(mask.flip(m_Components[GetComponentId<Comps>()].first), ...);
-		return mask;
-	}
-
-	template<typename Comp>
-	void RegisterComponent()
-	{
-		ASSERT(m_Components.size() < k_MaxComponents,
-			"Cannot register more than '" STRINGIFY(k_MaxComponents) "' components !");
-		auto &component = m_Components[GetComponentId<Comp>()];
-		component.first = m_Components.size() - 1;
-		LOG("Registered component '%s' !", GetComponentName<Comp>());
-	};
-
-private:
-	EntityStore m_Entities;
-	CompStore m_Components;
+#pragma once
+
+#include "Config.h"
+#include "util/Log.h"
+#include "util/DynamicPool.hpp"
+#include "util/SparsePool.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <vector>
+#include <unordered_map>
+#include <tuple>
+#include <type_traits>
+
+using EntId = uint32_t;
+using CompMask = std::bitset<k_MaxComponents>;
+
+// An EntId packs the entity's slot index with the generation of that slot, so handles to destroyed
+// entities are detectable once the slot is recycled. A slot whose generation reaches all ones is
+// retired instead of wrapping, so stale handles never become valid again and no live entity's id
+// can equal 'k_NullEnt'.
+static constexpr uint32_t k_EntIndexBits = 20;
+static constexpr EntId k_EntIndexMask = (1u << k_EntIndexBits) - 1;
+static constexpr uint32_t k_EntRetiredGeneration = (1u << (32 - k_EntIndexBits)) - 1;
+static constexpr EntId k_NullEnt = ~EntId(0);
+
+constexpr uint32_t GetEntIndex(EntId id) { return id & k_EntIndexMask; }
+constexpr uint32_t GetEntGeneration(EntId id) { return id >> k_EntIndexBits; }
+constexpr EntId MakeEntId(uint32_t index, uint32_t generation)
+{
+	return (generation << k_EntIndexBits) | (index & k_EntIndexMask);
+}
+
+template<typename Comp>
+constexpr const char *GetComponentName() { return nullptr; }
+template<typename Comp>
+constexpr bool IsSparseComponent() { return false; }
+
+// Component types are numbered densely in order of first use, which for declared components is
+// their registration by 'DECL_COMPONENT' during static initialisation. The index is the component's
+// bit in masks and its slot in every per component array, so lookups never hash.
+inline size_t NextComponentIndex()
+{
+	static std::atomic<size_t> s_Next{ 0 };
+	return s_Next++;
+}
+
+template<typename Comp>
+size_t GetComponentIndex()
+{
+	static const size_t s_Index = NextComponentIndex();
+	return s_Index;
+}
+
+struct Entity
+{
+	EntId Id;
+	CompMask Mask;
+
+	// Location of the entity's components, 'Archetype' is 'k_NoArchetype' once destroyed.
+	uint32_t Archetype;
+	uint32_t Row;
+};
+
+static constexpr uint32_t k_NoArchetype = ~uint32_t(0);
+
+// Registry ticks at which a component was added to its entity and last accessed for writing.
+struct ComponentTicks
+{
+	uint32_t Added;
+	uint32_t Changed;
+};
+
+// True if 'tick' is at or after 'since', robust to the tick counter wrapping.
+constexpr bool IsTickNewer(uint32_t tick, uint32_t since)
+{
+	return static_cast<int32_t>(tick - since) >= 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+//	Archetype
+//
+//	Every entity with the same component mask lives in the same archetype. Each component of the
+//	archetype has its own column, and row 'n' of every column belongs to 'Entities[n]'. Columns
+//	keep the change ticks of their rows alongside the components.
+//-------------------------------------------------------------------------------------------------
+struct Archetype
+{
+	static constexpr uint8_t k_NoColumn = 0xFF;
+
+	struct Column
+	{
+		size_t Index;
+		DynamicPool Pool;
+		std::vector<ComponentTicks> Ticks;
+	};
+
+	Archetype(const CompMask &mask, const std::vector<size_t> &compSizes)
+		: Mask(mask)
+	{
+		ColumnIndices.fill(k_NoColumn);
+		for (size_t i = 0; i < compSizes.size(); ++i)
+		{
+			if (mask[i])
+			{
+				ColumnIndices[i] = static_cast<uint8_t>(Columns.size());
+				Columns.push_back({ i, DynamicPool(compSizes[i]), {} });
+			}
+		}
+	}
+
+	size_t Size() const { return Entities.size(); }
+
+	template<typename Comp>
+	Comp *GetColumn(size_t compIndex)
+	{
+		return reinterpret_cast<Comp *>(Columns[ColumnIndices[compIndex]].Pool.Data());
+	}
+
+	ComponentTicks *GetTicks(size_t compIndex)
+	{
+		return Columns[ColumnIndices[compIndex]].Ticks.data();
+	}
+
+	uint8_t *GetRaw(size_t column, size_t row)
+	{
+		return Columns[column].Pool.At(row);
+	}
+
+	void Reserve(size_t count)
+	{
+		Entities.reserve(count);
+		for (auto &column : Columns)
+		{
+			column.Pool.Reserve(count);
+			column.Ticks.reserve(count);
+		}
+	}
+
+	// Appends a row whose components all count as added and changed at 'tick'.
+	size_t AddRow(EntId id, uint32_t tick)
+	{
+		size_t row = Entities.size();
+		Entities.push_back(id);
+		for (auto &column : Columns)
+		{
+			column.Pool.Get(row);
+			column.Ticks.push_back({ tick, tick });
+		}
+		return row;
+	}
+
+	// Appends 'count' rows at once, returning the first. Components are left for the caller to fill.
+	size_t AddRows(const EntId *ids, size_t count, uint32_t tick)
+	{
+		size_t first = Entities.size();
+		Entities.insert(Entities.end(), ids, ids + count);
+		for (auto &column : Columns)
+		{
+			column.Pool.Get(Entities.size() - 1);
+			column.Ticks.resize(Entities.size(), { tick, tick });
+		}
+		return first;
+	}
+
+	// Swap-removes 'row' by moving the last row into its place.
+	void RemoveRow(size_t row)
+	{
+		size_t last = Entities.size() - 1;
+		if (row != last)
+		{
+			for (size_t i = 0; i < Columns.size(); ++i)
+			{
+				memcpy(GetRaw(i, row), GetRaw(i, last), Columns[i].Pool.GetStride());
+				Columns[i].Ticks[row] = Columns[i].Ticks[last];
+			}
+			Entities[row] = Entities[last];
+		}
+		Entities.pop_back();
+		for (auto &column : Columns)
+		{
+			column.Ticks.pop_back();
+		}
+	}
+
+	CompMask Mask;
+	std::vector<EntId> Entities;
+	std::vector<Column> Columns;
+	std::array<uint8_t, k_MaxComponents> ColumnIndices;
+};
+
+class EntityManager
+{
+	friend class Registry;
+	template<typename> friend class ComponentRegisterer;
+	template<typename...> friend class Query;
+	template<typename> friend class OnRemoved;
+	template<bool, typename...> friend class ChangeObserver;
+
+	struct ComponentInfo
+	{
+		size_t Size = 0;
+		bool Sparse = false;
+		bool Registered = false;
+	};
+
+	using EntityStore = std::vector<Entity>;
+	using CompStore = std::array<ComponentInfo, k_MaxComponents>;
+	using ArchetypeStore = std::vector<Archetype>;
+	using SparseStore = std::vector<SparsePool>;
+
+private:
+	EntityManager() = default;
+
+	EntId Create()
+	{
+		uint32_t archetype = FindOrCreateArchetype(CompMask());
+
+		uint32_t index;
+		if (!m_FreeIndices.empty())
+		{
+			index = m_FreeIndices.back();
+			m_FreeIndices.pop_back();
+		}
+		else
+		{
+			ASSERT(m_Entities.size() <= k_EntIndexMask,
+				"Cannot create more than '%u' entities !", k_EntIndexMask + 1);
+			index = static_cast<uint32_t>(m_Entities.size());
+			m_Entities.emplace_back();
+			m_Entities[index].Id = MakeEntId(index, 0);
+		}
+
+		Entity &entity = m_Entities[index];
+		entity.Mask = CompMask();
+		entity.Archetype = archetype;
+		entity.Row = static_cast<uint32_t>(m_Archetypes[archetype].AddRow(entity.Id, GetTick()));
+		return entity.Id;
+	}
+
+	// Creates 'count' entities with the components 'Comps', each initialised to a copy of its
+	// prototype, and writes their ids to 'ids'. Storage is sized once for the whole batch and
+	// table columns are filled in one pass, instead of moving each entity through an archetype
+	// per component added.
+	template<typename... Comps>
+	void CreateMany(EntId *ids, size_t count, const Comps &...prototypes)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		CompMask mask = GetMask<Comps...>();
+		uint32_t archetypeIndex = FindOrCreateArchetype(mask & m_TableMask);
+		Reserve<Comps...>(count);
+
+		Archetype &archetype = m_Archetypes[archetypeIndex];
+		uint32_t firstRow = static_cast<uint32_t>(archetype.Size());
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint32_t index;
+			if (!m_FreeIndices.empty())
+			{
+				index = m_FreeIndices.back();
+				m_FreeIndices.pop_back();
+			}
+			else
+			{
+				ASSERT(m_Entities.size() <= k_EntIndexMask,
+					"Cannot create more than '%u' entities !", k_EntIndexMask + 1);
+				index = static_cast<uint32_t>(m_Entities.size());
+				m_Entities.emplace_back();
+				m_Entities[index].Id = MakeEntId(index, 0);
+			}
+
+			Entity &entity = m_Entities[index];
+			entity.Mask = mask;
+			entity.Archetype = archetypeIndex;
+			entity.Row = firstRow + static_cast<uint32_t>(i);
+			ids[i] = entity.Id;
+		}
+
+		uint32_t tick = GetTick();
+		archetype.AddRows(ids, count, tick);
+
+		([&](const auto &prototype) {
+			using Comp = std::decay_t<decltype(prototype)>;
+			size_t index = GetIndex<Comp>();
+			if constexpr (IsSparseComponent<Comp>())
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					uint32_t entIndex = GetEntIndex(ids[i]);
+					*reinterpret_cast<Comp *>(m_SparsePools[index].Insert(entIndex)) = prototype;
+					*reinterpret_cast<ComponentTicks *>(m_SparseTicks[index].Insert(entIndex)) = { tick, tick };
+				}
+			}
+			else
+			{
+				std::fill_n(archetype.GetColumn<Comp>(index) + firstRow, count, prototype);
+			}
+		}(prototypes), ...);
+	}
+
+	void Destroy(EntId id)
+	{
+		ASSERT(IsValid(id), "Attempt to destroy invalid entity !");
+		if (!IsValid(id))
+		{
+			return;
+		}
+
+		Entity &entity = m_Entities[GetEntIndex(id)];
+		for (size_t i = 0; i < m_SparsePools.size(); ++i)
+		{
+			if (entity.Mask[i])
+			{
+				NotifyRemoved(i, id);
+				if (!m_TableMask[i])
+				{
+					m_SparsePools[i].Remove(GetEntIndex(id));
+					m_SparseTicks[i].Remove(GetEntIndex(id));
+				}
+			}
+		}
+		RemoveRow(entity);
+
+		uint32_t generation = GetEntGeneration(id) + 1;
+		entity.Id = MakeEntId(GetEntIndex(id), generation);
+		entity.Mask = CompMask();
+		entity.Archetype = k_NoArchetype;
+		if (generation != k_EntRetiredGeneration)
+		{
+			m_FreeIndices.push_back(GetEntIndex(id));
+		}
+	}
+
+	bool IsValid(EntId id) const
+	{
+		uint32_t index = GetEntIndex(id);
+		return index < m_Entities.size()
+			&& m_Entities[index].Id == id
+			&& m_Entities[index].Archetype != k_NoArchetype;
+	}
+
+	// False for destroyed entities, whose slot may already hold another entity.
+	template<typename Comp>
+	bool HasComponent(EntId id)
+	{
+		size_t index = GetIndex<Comp>();
+		ASSERT(m_Components[index].Registered, "Attempt to access invalid entities component !");
+		return IsValid(id) && m_Entities[GetEntIndex(id)].Mask[index];
+	}
+
+	template<typename Comp, typename... Args>
+	void AddComponent(EntId id, Args &&...args)
+	{
+		ASSERT(IsValid(id), "Attempt to add component to invalid entity !");
+		if (!IsValid(id))
+		{
+			return;
+		}
+		if (!HasComponent<Comp>(id))
+		{
+			Entity &entity = m_Entities[GetEntIndex(id)];
+			size_t index = GetIndex<Comp>();
+			if constexpr (IsSparseComponent<Comp>())
+			{
+				m_SparsePools[index].Insert(GetEntIndex(id));
+				m_SparseTicks[index].Insert(GetEntIndex(id));
+				m_SparseTicks[index].Get<ComponentTicks>(GetEntIndex(id)) = { GetTick(), GetTick() };
+				entity.Mask.set(index);
+			}
+			else
+			{
+				CompMask mask = entity.Mask;
+				mask.set(index);
+				MoveEntity(entity, FindOrCreateArchetype(mask & m_TableMask));
+				entity.Mask = mask;
+			}
+
+			GetComponent<Comp>(id) = Comp{args...};
+		}
+	}
+
+	template<typename Comp>
+	void RemoveComponent(EntId id)
+	{
+		ASSERT(IsValid(id), "Attempt to remove component from invalid entity !");
+		if (!IsValid(id))
+		{
+			return;
+		}
+		if (HasComponent<Comp>(id))
+		{
+			Entity &entity = m_Entities[GetEntIndex(id)];
+			size_t index = GetIndex<Comp>();
+			NotifyRemoved(index, id);
+			if constexpr (IsSparseComponent<Comp>())
+			{
+				m_SparsePools[index].Remove(GetEntIndex(id));
+				m_SparseTicks[index].Remove(GetEntIndex(id));
+				entity.Mask.reset(index);
+			}
+			else
+			{
+				CompMask mask = entity.Mask;
+				mask.reset(index);
+				MoveEntity(entity, FindOrCreateArchetype(mask & m_TableMask));
+				entity.Mask = mask;
+			}
+		}
+	}
+
+	template<typename Comp>
+	Comp &GetComponent(EntId id)
+	{
+		ASSERT(IsValid(id), "Attempt to access component of invalid entity !");
+		ASSERT(HasComponent<Comp>(id),
+			"Attempt to access invalid entities component !");
+		return Fetch<Comp>(m_Entities[GetEntIndex(id)], GetIndex<Comp>());
+	}
+
+	// Unchecked component access, for callers which already know the entity has 'Comp'.
+	template<typename Comp>
+	Comp &Fetch(const Entity &entity, size_t index)
+	{
+		if constexpr (IsSparseComponent<std::remove_const_t<Comp>>())
+		{
+			return m_SparsePools[index].Get<Comp>(GetEntIndex(entity.Id));
+		}
+		else
+		{
+			return m_Archetypes[entity.Archetype].GetColumn<Comp>(index)[entity.Row];
+		}
+	}
+
+	ComponentTicks &GetTicks(const Entity &entity, size_t index)
+	{
+		if (m_TableMask[index])
+		{
+			return m_Archetypes[entity.Archetype].GetTicks(index)[entity.Row];
+		}
+		return m_SparseTicks[index].Get<ComponentTicks>(GetEntIndex(entity.Id));
+	}
+
+	// Marks 'Comp' of the entity as changed, accessing a component as const never does.
+	template<typename Comp>
+	void Touch(const Entity &entity, size_t index, uint32_t tick)
+	{
+		if constexpr (!std::is_const_v<Comp>)
+		{
+			if constexpr (IsSparseComponent<Comp>())
+			{
+				m_SparseTicks[index].Get<ComponentTicks>(GetEntIndex(entity.Id)).Changed = tick;
+			}
+			else
+			{
+				m_Archetypes[entity.Archetype].GetTicks(index)[entity.Row].Changed = tick;
+			}
+		}
+	}
+
+	uint32_t GetTick() const { return m_Tick.load(std::memory_order_relaxed); }
+	// Starts a new tick, so changes made from now on are told apart from earlier ones.
+	uint32_t AdvanceTick() { return ++m_Tick; }
+
+	void NotifyRemoved(size_t index, EntId id)
+	{
+		for (auto *listener : m_RemovedListeners[index])
+		{
+			listener->push_back(id);
+		}
+	}
+
+	template<typename Comp>
+	size_t GetIndex()
+	{
+		return GetComponentIndex<std::remove_const_t<Comp>>();
+	}
+
+	template <typename... Comps>
+	CompMask GetMask()
+	{
+		CompMask mask;
+		(mask.set(GetIndex<Comps>()), ...);
+		return mask;
+	}
+
+	template<typename... Comps>
+	void Reserve(size_t count)
+	{
+		CompMask mask = GetMask<Comps...>();
+		m_Entities.reserve(m_Entities.size() + count);
+		Archetype &archetype = m_Archetypes[FindOrCreateArchetype(mask & m_TableMask)];
+		archetype.Reserve(archetype.Size() + count);
+		([&]() {
+			if constexpr (IsSparseComponent<Comps>())
+			{
+				SparsePool &pool = m_SparsePools[GetIndex<Comps>()];
+				pool.Reserve(pool.Size() + count);
+				m_SparseTicks[GetIndex<Comps>()].Reserve(pool.Size() + count);
+			}
+		}(), ...);
+	}
+
+	uint32_t FindOrCreateArchetype(const CompMask &mask)
+	{
+		auto it = m_ArchetypeLookup.find(mask);
+		if (it != m_ArchetypeLookup.end())
+		{
+			return it->second;
+		}
+
+		uint32_t index = static_cast<uint32_t>(m_Archetypes.size());
+		m_Archetypes.emplace_back(mask, m_ComponentSizes);
+		m_ArchetypeLookup[mask] = index;
+		return index;
+	}
+
+	// Moves an entity and the components it keeps into another archetype.
+	void MoveEntity(Entity &entity, uint32_t to)
+	{
+		Archetype &src = m_Archetypes[entity.Archetype];
+		Archetype &dst = m_Archetypes[to];
+
+		// Components the entity keeps also keep their ticks, only new ones count as added.
+		size_t row = dst.AddRow(entity.Id, GetTick());
+		for (size_t i = 0; i < src.Columns.size(); ++i)
+		{
+			uint8_t column = dst.ColumnIndices[src.Columns[i].Index];
+			if (column != Archetype::k_NoColumn)
+			{
+				memcpy(dst.GetRaw(column, row), src.GetRaw(i, entity.Row), src.Columns[i].Pool.GetStride());
+				dst.Columns[column].Ticks[row] = src.Columns[i].Ticks[entity.Row];
+			}
+		}
+
+		RemoveRow(entity);
+		entity.Archetype = to;
+		entity.Row = static_cast<uint32_t>(row);
+	}
+
+	// Removes an entity's row from its archetype, patching the row of the entity swapped into it.
+	void RemoveRow(const Entity &entity)
+	{
+		Archetype &archetype = m_Archetypes[entity.Archetype];
+		archetype.RemoveRow(entity.Row);
+		if (entity.Row < archetype.Size())
+		{
+			m_Entities[GetEntIndex(archetype.Entities[entity.Row])].Row = entity.Row;
+		}
+	}
+
+	template<typename Comp>
+	void RegisterComponent()
+	{
+		size_t index = GetIndex<Comp>();
+		ASSERT(index < k_MaxComponents, "Cannot register more than '%d' components !", k_MaxComponents);
+
+		auto &component = m_Components[index];
+		if (component.Registered)
+		{
+			return;
+		}
+
+		component.Size = sizeof(Comp);
+		component.Sparse = IsSparseComponent<Comp>();
+		component.Registered = true;
+
+		// Types used before being declared leave unregistered gaps, which stay empty.
+		if (index >= m_ComponentSizes.size())
+		{
+			m_ComponentSizes.resize(index + 1, 0);
+			m_SparsePools.resize(index + 1);
+			m_SparseTicks.resize(index + 1);
+		}
+		m_ComponentSizes[index] = sizeof(Comp);
+		m_SparsePools[index] = SparsePool(component.Sparse ? sizeof(Comp) : 0);
+		m_SparseTicks[index] = SparsePool(component.Sparse ? sizeof(ComponentTicks) : 0);
+		m_TableMask.set(index, !component.Sparse);
+		LOG("Registered component '%s' !", GetComponentName<Comp>());
+	};
+
+private:
+	EntityStore m_Entities;
+	std::vector<uint32_t> m_FreeIndices;
+	CompStore m_Components;
+	std::vector<size_t> m_ComponentSizes;
+
+	// Components are stored in archetype columns unless declared with 'DECL_SPARSE_COMPONENT', in
+	// which case they live in a sparse set so that adding or removing them never moves the entity.
+	CompMask m_TableMask;
+	ArchetypeStore m_Archetypes;
+	std::unordered_map<CompMask, uint32_t> m_ArchetypeLookup;
+	SparseStore m_SparsePools;
+	// Change ticks of sparse components, kept in a sparse set of their own with the same ids.
+	SparseStore m_SparseTicks;
+
+	std::atomic<uint32_t> m_Tick{ 1 };
+	// Lists each removal of a component is appended to, owned by 'OnRemoved' observers.
+	std::array<std::vector<std::vector<EntId> *>, k_MaxComponents> m_RemovedListeners;
 };
\ No newline at end of file
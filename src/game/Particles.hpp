@@ -1,121 +1,284 @@
 #pragma once
 
-#include "app/Input.hpp"
+#include "game/Registry.hpp"
 #include "graphics/Renderer.hpp"
-#include "maths/Algebra.hpp"
+#include "maths/Simd.hpp"
+#include "util/JobSystem.hpp"
 #include "util/Random.hpp"
 
-#include <functional>
-#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <vector>
 
+//-------------------------------------------------------------------------------------------------
+//	ParticleSystem
+//
+//	Particles are not entities, each attribute is kept in its own float stream so the update runs
+//	as SIMD kernels over the live range [0, m_Count). Dead particles are swap-removed, so the live
+//	range stays packed and the system grows as needed.
+//
+//	Colour and size over lifetime are not simulated, each particle stores its birth time and the
+//	renderer interpolates between the emitter's initial and final values on the GPU.
+//
+//	The clock is a double, but birth times and the time handed to the renderer are floats relative
+//	to an epoch which moves up every 'k_RebasePeriod' seconds, so particle ages keep the same
+//	resolution however long the system runs.
+//-------------------------------------------------------------------------------------------------
 class ParticleSystem
 {
-	static constexpr size_t k_MaxParticles = 4 * 1024; 
+	static constexpr float k_Gravity = -9.81f;
+	static constexpr size_t k_UpdateChunkSize = 16 * 1024;
+	// Floats up to 64 still resolve steps of under 8 microseconds.
+	static constexpr double k_RebasePeriod = 64.0;
+
+	enum Stream
+	{
+		PositionX, PositionY, PositionZ,
+		VelocityX, VelocityY, VelocityZ,
+		ColourR, ColourG, ColourB, ColourA,
+		FinalColourR, FinalColourG, FinalColourB, FinalColourA,
+		InitialSize, FinalSize,
+		BirthTime, Lifetime,
+		StreamCount
+	};
 
 public:
 	ParticleSystem()
+		: m_Count(0), m_Clock(0.0), m_Epoch(0.0), m_Time(0.0f)
 	{
-		Registry *reg = Registry::Get();
-
-		m_NextParticleIndex = 0;
-		m_Particles.resize(k_MaxParticles);
-		for (auto &particle : m_Particles)
-		{
-			particle.Id = reg->Create();
-			particle.Lifetime = 0.0f;
-			particle.Alivetime = 0.0f;
-			particle.Alive = false;
-
-			reg->AddComponent<TransformComponent>(particle.Id);
-			reg->AddComponent<PhysicsComponent>(particle.Id);
-			reg->AddComponent<SpriteComponent>(particle.Id);
-			
-			auto &physics = reg->GetComponent<PhysicsComponent>(particle.Id);
-			physics.Active = false;
-			auto &sprite = reg->GetComponent<SpriteComponent>(particle.Id);
-			sprite.Visible = false;
-			sprite.Billboard = true;
-		}
 	}
 
 	void Update(float dt)
 	{
 		Registry *reg = Registry::Get();
 
-		reg->View<TransformComponent, ParticleEmitter>([&](EntId id, const auto &transform, const auto &emitter) {
-			auto &system = m_Systems[id];
-			if (system.EmissionPeriodTime >= emitter.EmissionPeriod)
+		m_Clock += dt;
+		if (m_Clock - m_Epoch >= k_RebasePeriod)
+		{
+			Rebase();
+		}
+		m_Time = static_cast<float>(m_Clock - m_Epoch);
+
+		reg->View<const TransformComponent, ParticleEmitter>([&](EntId id, const auto &transform, auto &emitter) {
+			emitter.EmissionAccumulator += emitter.EmissionRate * dt;
+			size_t count = static_cast<size_t>(emitter.EmissionAccumulator);
+			emitter.EmissionAccumulator -= static_cast<float>(count);
+
+			if (emitter.BurstPeriod > 0.0f)
 			{
-				auto &particle = m_Particles[m_NextParticleIndex];
-				if (!particle.Alive)
+				emitter.BurstTime += dt;
+				if (emitter.BurstTime >= emitter.BurstPeriod)
 				{
-					particle.Lifetime = Random::Float(emitter.Lifetime - emitter.LifetimeVariation, emitter.Lifetime + emitter.LifetimeVariation);
-					particle.Alivetime = 0.0f;
-					particle.Alive = true;
-
-					auto &particleTransform = reg->GetComponent<TransformComponent>(particle.Id);
-					particleTransform.Position = transform.Position;
-					particleTransform.Scale = glm::vec3(0.1f);
-
-					glm::vec3 dir = emitter.Direction;
-					dir.x += emitter.DirectionVariation.x * Random::Float(-1.0f, 1.0f);
-					dir.y += emitter.DirectionVariation.y * Random::Float(-1.0f, 1.0f);
-					dir.y += emitter.DirectionVariation.z * Random::Float(-1.0f, 1.0f);
-					float speed = Random::Float(emitter.Speed - emitter.SpeedVariation, emitter.Speed + emitter.SpeedVariation);
-					auto &particlePhysics = reg->GetComponent<PhysicsComponent>(particle.Id);
-					particlePhysics.Velocity = dir * speed;
-					particlePhysics.Active = true;
-
-					glm::vec4 colour = emitter.InitialColour;
-					auto &particleSprite = reg->GetComponent<SpriteComponent>(particle.Id);
-					particleSprite.Colour = colour;
-					particleSprite.Visible = true;
-
-					m_NextParticleIndex = (m_NextParticleIndex + 1) % k_MaxParticles;
+					emitter.BurstTime -= emitter.BurstPeriod;
+					count += emitter.BurstCount;
 				}
-				system.EmissionPeriodTime = 0.0f;
+			}
+
+			if (count > 0)
+			{
+				Emit(transform.Position, emitter, count);
 			}
 		});
 
-		for (auto it = m_Systems.begin(); it != m_Systems.end(); ++it)
+		JobSystem::ParallelFor(m_Count, k_UpdateChunkSize, [&](size_t begin, size_t end) {
+			Integrate(begin, end, dt);
+		});
+
+		Compact();
+	}
+
+	// Must be drawn with a render context whose time is 'GetTime()'.
+	void Render()
+	{
+		auto stream = [&](Stream s) { return m_Streams[s].data(); };
+
+		for (size_t i = 0; i < m_Count; ++i)
 		{
-			it->second.EmissionPeriodTime += dt;
+			ParticleInstance instance;
+			instance.Position = glm::vec3{ stream(PositionX)[i], stream(PositionY)[i], stream(PositionZ)[i] };
+			instance.BirthTime = stream(BirthTime)[i];
+			instance.InitialColour = glm::vec4{ stream(ColourR)[i], stream(ColourG)[i], stream(ColourB)[i], stream(ColourA)[i] };
+			instance.FinalColour = glm::vec4{ stream(FinalColourR)[i], stream(FinalColourG)[i], stream(FinalColourB)[i], stream(FinalColourA)[i] };
+			instance.Lifetime = stream(Lifetime)[i];
+			instance.InitialSize = stream(InitialSize)[i];
+			instance.FinalSize = stream(FinalSize)[i];
+			Renderer::SubmitParticle(instance);
 		}
+	}
+
+	size_t GetCount() const { return m_Count; }
+	// Simulation clock relative to the current epoch, advanced by every update.
+	float GetTime() const { return m_Time; }
+
+private:
+	// Spawns 'count' particles as one batch at the end of the live range. Random draws for the
+	// whole batch are written straight into the streams which consume them.
+	void Emit(glm::vec3 position, const ParticleEmitter &emitter, size_t count)
+	{
+		size_t first = Allocate(count);
+		m_Scratch.resize(count);
+
+		float *vx = m_Streams[VelocityX].data() + first;
+		float *vy = m_Streams[VelocityY].data() + first;
+		float *vz = m_Streams[VelocityZ].data() + first;
+		float *speed = m_Scratch.data();
+
+		Random::Floats(vx, count, -1.0f, 1.0f);
+		Random::Floats(vy, count, -1.0f, 1.0f);
+		Random::Floats(vz, count, -1.0f, 1.0f);
+		Random::Floats(speed, count, emitter.Speed - emitter.SpeedVariation, emitter.Speed + emitter.SpeedVariation);
+		Random::Floats(m_Streams[Lifetime].data() + first, count,
+			emitter.Lifetime - emitter.LifetimeVariation, emitter.Lifetime + emitter.LifetimeVariation);
 
-		for (auto &particle : m_Particles)
+		for (size_t i = 0; i < count; ++i)
 		{
-			if (particle.Alive)
-			{
-				if (particle.Alivetime >= particle.Lifetime)
-				{
-					particle.Alive = false;
+			vx[i] = (emitter.Direction.x + emitter.DirectionVariation.x * vx[i]) * speed[i];
+			vy[i] = (emitter.Direction.y + emitter.DirectionVariation.y * vy[i]) * speed[i];
+			vz[i] = (emitter.Direction.z + emitter.DirectionVariation.z * vz[i]) * speed[i];
+		}
 
-					auto &physics = reg->GetComponent<PhysicsComponent>(particle.Id);
-					physics.Active = false;
-					auto &sprite = reg->GetComponent<SpriteComponent>(particle.Id);
-					sprite.Visible = false;
-				}
+		auto fill = [&](Stream stream, float value) {
+			std::fill_n(m_Streams[stream].data() + first, count, value);
+		};
+		fill(PositionX, position.x);
+		fill(PositionY, position.y);
+		fill(PositionZ, position.z);
+		fill(ColourR, emitter.InitialColour.r);
+		fill(ColourG, emitter.InitialColour.g);
+		fill(ColourB, emitter.InitialColour.b);
+		fill(ColourA, emitter.InitialColour.a);
+		fill(FinalColourR, emitter.FinalColour.r);
+		fill(FinalColourG, emitter.FinalColour.g);
+		fill(FinalColourB, emitter.FinalColour.b);
+		fill(FinalColourA, emitter.FinalColour.a);
+		fill(InitialSize, emitter.InitialSize);
+		fill(FinalSize, emitter.FinalSize);
+		fill(BirthTime, m_Time);
+	}
 
-				particle.Alivetime += dt;
+	// Appends 'count' particles to the live range, returning the index of the first.
+	size_t Allocate(size_t count)
+	{
+		size_t first = m_Count;
+		m_Count += count;
+		if (m_Count > m_Streams[0].size())
+		{
+			size_t capacity = std::max(m_Count, m_Streams[0].size() * 2);
+			for (auto &stream : m_Streams)
+			{
+				stream.resize(capacity);
 			}
 		}
+		return first;
 	}
 
-private:
-	struct Particle
+	void Integrate(size_t begin, size_t end, float dt)
 	{
-		EntId Id;
-		float Alivetime = 0.0f, Lifetime = 0.0f;
-		bool Alive = false;
-	};
+		float *px = m_Streams[PositionX].data();
+		float *py = m_Streams[PositionY].data();
+		float *pz = m_Streams[PositionZ].data();
+		float *vx = m_Streams[VelocityX].data();
+		float *vy = m_Streams[VelocityY].data();
+		float *vz = m_Streams[VelocityZ].data();
+
+		size_t i = begin;
+
+#if SIMD_AVX
+		const __m256 dt8 = _mm256_set1_ps(dt);
+		const __m256 gravity8 = _mm256_set1_ps(k_Gravity * dt);
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 vy8 = _mm256_add_ps(_mm256_loadu_ps(vy + i), gravity8);
+			_mm256_storeu_ps(vy + i, vy8);
+			_mm256_storeu_ps(px + i, _mm256_add_ps(_mm256_loadu_ps(px + i), _mm256_mul_ps(_mm256_loadu_ps(vx + i), dt8)));
+			_mm256_storeu_ps(py + i, _mm256_add_ps(_mm256_loadu_ps(py + i), _mm256_mul_ps(vy8, dt8)));
+			_mm256_storeu_ps(pz + i, _mm256_add_ps(_mm256_loadu_ps(pz + i), _mm256_mul_ps(_mm256_loadu_ps(vz + i), dt8)));
+		}
+#endif
+
+#if SIMD_SSE
+		const __m128 dt4 = _mm_set1_ps(dt);
+		const __m128 gravity4 = _mm_set1_ps(k_Gravity * dt);
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 vy4 = _mm_add_ps(_mm_loadu_ps(vy + i), gravity4);
+			_mm_storeu_ps(vy + i, vy4);
+			_mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(_mm_loadu_ps(vx + i), dt4)));
+			_mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(vy4, dt4)));
+			_mm_storeu_ps(pz + i, _mm_add_ps(_mm_loadu_ps(pz + i), _mm_mul_ps(_mm_loadu_ps(vz + i), dt4)));
+		}
+#endif
+
+		for (; i < end; ++i)
+		{
+			vy[i] += k_Gravity * dt;
+			px[i] += vx[i] * dt;
+			py[i] += vy[i] * dt;
+			pz[i] += vz[i] * dt;
+		}
+	}
 
-	struct System
+	// Moves the epoch up to the clock and shifts live birth times by as much. The shift is rounded
+	// to a float first and the epoch moved by exactly that, so ages are unchanged.
+	void Rebase()
 	{
-		float EmissionPeriodTime = std::numeric_limits<float>::infinity();
-	};
+		float shift = static_cast<float>(m_Clock - m_Epoch);
+		m_Epoch += shift;
+
+		float *birth = m_Streams[BirthTime].data();
+		for (size_t i = 0; i < m_Count; ++i)
+		{
+			birth[i] -= shift;
+		}
+	}
+
+	// Swap-removes every particle which has outlived its lifetime.
+	void Compact()
+	{
+		const float *birth = m_Streams[BirthTime].data();
+		const float *lifetime = m_Streams[Lifetime].data();
+
+#if SIMD_SSE
+		const __m128 time4 = _mm_set1_ps(m_Time);
+#endif
+
+		size_t i = 0;
+		while (i < m_Count)
+		{
+#if SIMD_SSE
+			// Skip whole blocks of live particles.
+			if (i + 4 <= m_Count)
+			{
+				__m128 age = _mm_sub_ps(time4, _mm_loadu_ps(birth + i));
+				__m128 dead = _mm_cmpge_ps(age, _mm_loadu_ps(lifetime + i));
+				if (_mm_movemask_ps(dead) == 0)
+				{
+					i += 4;
+					continue;
+				}
+			}
+#endif
+
+			if (m_Time - birth[i] >= lifetime[i])
+			{
+				size_t last = --m_Count;
+				for (auto &stream : m_Streams)
+				{
+					stream[i] = stream[last];
+				}
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
 
 private:
-	size_t m_NextParticleIndex;
-	std::vector<Particle> m_Particles;
-	std::unordered_map<EntId, System> m_Systems;
+	size_t m_Count;
+	double m_Clock;
+	double m_Epoch;
+	float m_Time;
+	std::array<std::vector<float>, StreamCount> m_Streams;
+	std::vector<float> m_Scratch;
 };
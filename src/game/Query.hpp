@@ -0,0 +1,378 @@
+#pragma once
+
+#include "game/Registry.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+//	Query
+//
+//	Persistent version of 'Registry::View' for systems which run every tick. The component
+//	indices, mask and matching archetypes are worked out once and kept, archetypes are only ever
+//	added so each refresh just checks the ones created since the last. Iterating yields
+//	'(id, comps...)' tuples of references, so it works with range-based for and structured
+//	bindings:
+//
+//		Query<const TransformComponent, PhysicsComponent> query;
+//		for (auto [id, transform, physics] : query) { ... }
+//
+//	Like a view, the registry must not change structurally while a query is iterated.
+//-------------------------------------------------------------------------------------------------
+template<typename... Comps>
+class Query
+{
+	static constexpr bool k_Sparse = (IsSparseComponent<std::remove_const_t<Comps>>() || ...);
+
+public:
+	using Item = std::tuple<EntId, Comps &...>;
+
+	class Iterator
+	{
+	public:
+		Iterator(Query *query, size_t outer)
+			: m_Query(query), m_Outer(outer), m_Row(0)
+		{
+			if constexpr (k_Sparse)
+			{
+				m_Pool = &m_Query->m_Registry->template GetSmallestPool<Comps...>();
+			}
+			Settle();
+		}
+
+		// The end sentinel, which must not settle, for sparse queries that would move it onto a match.
+		struct End {};
+		Iterator(Query *query, size_t outer, End)
+			: m_Query(query), m_Outer(outer), m_Row(0)
+		{
+		}
+
+		// Non const components are marked as changed when dereferenced.
+		Item operator*() const
+		{
+			return Get(std::index_sequence_for<Comps...>{});
+		}
+
+		Iterator &operator++()
+		{
+			if (++m_Row >= m_Size)
+			{
+				Settle();
+			}
+			return *this;
+		}
+
+		bool operator==(const Iterator &other) const { return m_Outer == other.m_Outer && m_Row == other.m_Row; }
+		bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+	private:
+		// Table queries walk the rows of each matching archetype, 'm_Outer' indexing the archetypes.
+		// Sparse queries walk the smallest pool, 'm_Row' indexing its ids and 'm_Outer' staying 0.
+		void Settle()
+		{
+			EntityManager &manager = m_Query->m_Registry->m_EntityManager;
+
+			if constexpr (k_Sparse)
+			{
+				const uint32_t *ids = m_Pool->GetIds().data();
+				while (m_Row < m_Pool->Size()
+					&& m_Query->m_Mask != (manager.m_Entities[ids[m_Row]].Mask & m_Query->m_Mask))
+				{
+					++m_Row;
+				}
+				if (m_Row == m_Pool->Size())
+				{
+					m_Outer = 1;
+					m_Row = 0;
+				}
+				// Every step has to check the next entity's mask.
+				m_Size = 0;
+			}
+			else
+			{
+				const auto &archetypes = m_Query->m_Archetypes;
+				while (m_Outer < archetypes.size() && m_Row >= manager.m_Archetypes[archetypes[m_Outer]].Size())
+				{
+					++m_Outer;
+					m_Row = 0;
+				}
+				if (m_Outer < archetypes.size())
+				{
+					m_Archetype = &manager.m_Archetypes[archetypes[m_Outer]];
+					m_Size = m_Archetype->Size();
+					m_Columns = GetColumns(std::index_sequence_for<Comps...>{});
+				}
+			}
+		}
+
+		template<size_t... I>
+		std::tuple<Comps *...> GetColumns(std::index_sequence<I...>) const
+		{
+			return std::make_tuple(m_Archetype->template GetColumn<Comps>(m_Query->m_Indices[I])...);
+		}
+
+		template<size_t... I>
+		Item Get(std::index_sequence<I...>) const
+		{
+			EntityManager &manager = m_Query->m_Registry->m_EntityManager;
+
+			if constexpr (k_Sparse)
+			{
+				const Entity &entity = manager.m_Entities[m_Pool->GetIds()[m_Row]];
+				(manager.template Touch<Comps>(entity, m_Query->m_Indices[I], manager.GetTick()), ...);
+				return Item(entity.Id, manager.template Fetch<Comps>(entity, m_Query->m_Indices[I])...);
+			}
+			else
+			{
+				(Registry::TouchRow<Comps>(*m_Archetype, m_Query->m_Indices[I], m_Row, manager.GetTick()), ...);
+				return Item(m_Archetype->Entities[m_Row], std::get<I>(m_Columns)[m_Row]...);
+			}
+		}
+
+		Query *m_Query;
+		size_t m_Outer;
+		size_t m_Row;
+		// Rows and columns of the current archetype for tables.
+		Archetype *m_Archetype = nullptr;
+		size_t m_Size = 0;
+		std::tuple<Comps *...> m_Columns;
+		const SparsePool *m_Pool = nullptr;
+	};
+
+	Query()
+		: m_Registry(Registry::Get())
+		, m_Indices{ m_Registry->m_EntityManager.template GetIndex<Comps>()... }
+		, m_Mask(m_Registry->m_EntityManager.template GetMask<Comps...>())
+		, m_Checked(0)
+	{
+	}
+
+	// Adds the archetypes created since the last refresh which match, iterating refreshes itself.
+	void Refresh()
+	{
+		if constexpr (!k_Sparse)
+		{
+			const auto &archetypes = m_Registry->m_EntityManager.m_Archetypes;
+			for (; m_Checked < archetypes.size(); ++m_Checked)
+			{
+				if (m_Mask == (archetypes[m_Checked].Mask & m_Mask))
+				{
+					m_Archetypes.push_back(static_cast<uint32_t>(m_Checked));
+				}
+			}
+		}
+	}
+
+	Iterator begin()
+	{
+		Refresh();
+		return Iterator(this, 0);
+	}
+
+	Iterator end()
+	{
+		return Iterator(this, k_Sparse ? 1 : m_Archetypes.size(), typename Iterator::End{});
+	}
+
+	// Calls 'func(id, comps...)' for every match, as 'Registry::View' does.
+	template<typename Func>
+	void Each(const Func &func)
+	{
+		Each(func, typename Registry::AcceptAll{});
+	}
+
+	// Same as 'Registry::ParallelView', with the same restrictions on 'func'.
+	template<typename Func>
+	void ParallelEach(const Func &func)
+	{
+		ParallelEach(func, typename Registry::AcceptAll{});
+	}
+
+private:
+	template<bool, typename...> friend class ChangeObserver;
+
+	template<typename Func, typename Filter>
+	void Each(const Func &func, const Filter &filter)
+	{
+		if constexpr (k_Sparse)
+		{
+			const SparsePool &pool = m_Registry->template GetSmallestPool<Comps...>();
+			m_Registry->template SparseRange<Comps...>(func, filter, m_Mask, m_Indices, pool.GetIds().data(), pool.Size(),
+				std::index_sequence_for<Comps...>{});
+		}
+		else
+		{
+			Refresh();
+			for (uint32_t index : m_Archetypes)
+			{
+				Archetype &archetype = m_Registry->m_EntityManager.m_Archetypes[index];
+				m_Registry->template TableRange<Comps...>(func, filter, archetype, 0, archetype.Size(), m_Indices,
+					std::index_sequence_for<Comps...>{});
+			}
+		}
+	}
+
+	template<typename Func, typename Filter>
+	void ParallelEach(const Func &func, const Filter &filter)
+	{
+		if constexpr (k_Sparse)
+		{
+			const SparsePool &pool = m_Registry->template GetSmallestPool<Comps...>();
+			const uint32_t *ids = pool.GetIds().data();
+			JobSystem::ParallelFor(pool.Size(), Registry::k_ParallelChunkSize, [&](size_t begin, size_t end) {
+				m_Registry->template SparseRange<Comps...>(func, filter, m_Mask, m_Indices, ids + begin, end - begin,
+					std::index_sequence_for<Comps...>{});
+			});
+		}
+		else
+		{
+			Refresh();
+			auto &archetypes = m_Registry->m_EntityManager.m_Archetypes;
+			m_Pointers.clear();
+			for (uint32_t index : m_Archetypes)
+			{
+				m_Pointers.push_back(&archetypes[index]);
+			}
+			m_Registry->template ParallelTableRanges<Comps...>(func, filter, m_Pointers.data(), m_Pointers.size(),
+				m_Indices);
+		}
+	}
+
+	Registry *m_Registry;
+	size_t m_Indices[sizeof...(Comps)];
+	CompMask m_Mask;
+
+	// Matching archetypes by index, as the archetype store may reallocate, and how many of the
+	// store's archetypes have been checked so far.
+	std::vector<uint32_t> m_Archetypes;
+	size_t m_Checked;
+	std::vector<Archetype *> m_Pointers;
+};
+
+//-------------------------------------------------------------------------------------------------
+//	OnAdded / OnChanged
+//
+//	Queries which only visit the entities whose first component was added, or accessed for
+//	writing, since the observer's previous run. Each run starts a new registry tick, so changes
+//	made while it runs, including its own writes to other components, are seen by the next run.
+//	An observer writing its own first component would see every entity it visits again.
+//
+//		OnChanged<const TransformComponent, WorldTransformComponent> moved;
+//		moved.Each([](EntId id, const auto &transform, auto &world) { ... });
+//
+//	The first run visits every match. Added components also count as changed.
+//-------------------------------------------------------------------------------------------------
+template<bool Added, typename... Comps>
+class ChangeObserver
+{
+public:
+	ChangeObserver()
+		: m_Since(0)
+	{
+	}
+
+	template<typename Func>
+	void Each(const Func &func)
+	{
+		m_Query.Each(func, BeginRun());
+	}
+
+	template<typename Func>
+	void ParallelEach(const Func &func)
+	{
+		m_Query.ParallelEach(func, BeginRun());
+	}
+
+private:
+	struct TickFilter
+	{
+		EntityManager *Manager;
+		size_t Index;
+		uint32_t Since;
+
+		bool operator()(Archetype &archetype, size_t row) const
+		{
+			return IsNewer(archetype.GetTicks(Index)[row]);
+		}
+
+		bool operator()(const Entity &entity) const
+		{
+			return IsNewer(Manager->GetTicks(entity, Index));
+		}
+
+		bool IsNewer(const ComponentTicks &ticks) const
+		{
+			return IsTickNewer(Added ? ticks.Added : ticks.Changed, Since);
+		}
+	};
+
+	TickFilter BeginRun()
+	{
+		EntityManager &manager = Registry::Get()->m_EntityManager;
+
+		TickFilter filter{ &manager, m_Query.m_Indices[0], m_Since };
+		m_Since = manager.AdvanceTick();
+		return filter;
+	}
+
+private:
+	Query<Comps...> m_Query;
+	uint32_t m_Since;
+};
+
+template<typename... Comps>
+using OnAdded = ChangeObserver<true, Comps...>;
+template<typename... Comps>
+using OnChanged = ChangeObserver<false, Comps...>;
+
+//-------------------------------------------------------------------------------------------------
+//	OnRemoved
+//
+//	Collects the entities which lost 'Comp', by removal or by being destroyed, until the next
+//	'Each'. Destroyed entities are no longer valid by then, only their ids are reported.
+//-------------------------------------------------------------------------------------------------
+template<typename Comp>
+class OnRemoved
+{
+public:
+	OnRemoved()
+	{
+		GetListeners().push_back(&m_Removed);
+	}
+
+	~OnRemoved()
+	{
+		auto &listeners = GetListeners();
+		listeners.erase(std::find(listeners.begin(), listeners.end(), &m_Removed));
+	}
+
+	OnRemoved(const OnRemoved &other) = delete;
+	OnRemoved& operator=(const OnRemoved &other) = delete;
+
+	// Calls 'func(id)' for each removal since the previous call.
+	template<typename Func>
+	void Each(const Func &func)
+	{
+		for (EntId id : m_Removed)
+		{
+			func(id);
+		}
+		m_Removed.clear();
+	}
+
+	bool Empty() const { return m_Removed.empty(); }
+
+private:
+	static std::vector<std::vector<EntId> *> &GetListeners()
+	{
+		EntityManager &manager = Registry::Get()->m_EntityManager;
+		return manager.m_RemovedListeners[manager.template GetIndex<Comp>()];
+	}
+
+private:
+	std::vector<EntId> m_Removed;
+};
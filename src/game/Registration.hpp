@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
+
 //-------------------------------------------------------------------------------------------------
 //	Components
 //-------------------------------------------------------------------------------------------------
@@ -15,6 +17,14 @@ struct TransformComponent
 
 DECL_COMPONENT(TransformComponent)
 
+// World matrix of the TransformComponent, only rebuilt when the transform changes.
+struct WorldTransformComponent
+{
+	glm::mat4 Matrix = glm::mat4(1.0f);
+};
+
+DECL_COMPONENT(WorldTransformComponent)
+
 struct PhysicsComponent
 {
 	glm::vec3 Velocity = glm::vec3{0, 0, 0};
@@ -37,6 +47,8 @@ struct MeshComponent
 {
 	glm::vec4 Colour = glm::vec4{1, 1, 1, 1};
 	bool Visible = true;
+	// Baked into the renderer's static batch instead of being submitted every frame.
+	bool Static = false;
 };
 
 DECL_COMPONENT(MeshComponent)
@@ -49,13 +61,25 @@ struct ParticleEmitter
 	float Speed;
 	float SpeedVariation;
 	
-	float EmissionPeriod;
+	// Particles emitted per second.
+	float EmissionRate;
 	
 	glm::vec3 Direction;
 	glm::vec3 DirectionVariation;
 
+	// Interpolated over each particle's lifetime.
 	glm::vec4 InitialColour;
 	glm::vec4 FinalColour;
+	float InitialSize = 0.1f;
+	float FinalSize = 0.1f;
+
+	// Extra particles emitted at once every 'BurstPeriod' seconds.
+	uint32_t BurstCount = 0;
+	float BurstPeriod = 0.0f;
+
+	// Emission state, owned by the particle system.
+	float EmissionAccumulator = 0.0f;
+	float BurstTime = 0.0f;
 };
 
-DECL_COMPONENT(ParticleEmitter)
\ No newline at end of file
+DECL_SPARSE_COMPONENT(ParticleEmitter)
\ No newline at end of file
@@ -1,13 +1,33 @@
 #pragma once
 
 #include "game/Entity.hpp"
+#include "util/JobSystem.hpp"
 
 #include <functional>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct Access
+{
+	CompMask Read;
+	CompMask Write;
+
+	bool ConflictsWith(const Access &other) const
+	{
+		return (Write & (other.Read | other.Write)).any() || (Read & other.Write).any();
+	}
+};
 
 class Registry
 {
 	template<typename> friend class ComponentRegisterer;
+	template<typename...> friend class Query;
+	template<bool, typename...> friend class ChangeObserver;
+	template<typename> friend class OnRemoved;
+
+	static constexpr size_t k_ParallelChunkSize = 1024;
 
 public:
 	static Registry *Get()
@@ -22,6 +42,32 @@ public:
 		return m_EntityManager.Create();
 	}
 
+	// Creates 'count' entities at once, each with a copy of every prototype component.
+	template<typename... Comps>
+	std::vector<EntId> CreateMany(size_t count, const Comps &...prototypes)
+	{
+		std::vector<EntId> ids(count);
+		m_EntityManager.CreateMany(ids.data(), count, prototypes...);
+		return ids;
+	}
+
+	void Destroy(EntId id)
+	{
+		m_EntityManager.Destroy(id);
+	}
+
+	bool IsValid(EntId id) const
+	{
+		return m_EntityManager.IsValid(id);
+	}
+
+	// Pre-sizes storage for 'count' entities with exactly the components 'Comps'.
+	template<typename... Comps>
+	void Reserve(size_t count)
+	{
+		m_EntityManager.Reserve<Comps...>(count);
+	}
+
 	template<typename Comp>
 	bool HasComponent(EntId id)
 	{
@@ -34,45 +80,193 @@ public:
 		m_EntityManager.AddComponent<Comp>(id, std::forward<Args>(args)...);
 	}
 
+	template<typename Comp>
+	void RemoveComponent(EntId id)
+	{
+		m_EntityManager.RemoveComponent<Comp>(id);
+	}
+
+	// Counts as a change of the component unless 'Comp' is const.
 	template<typename Comp>
 	Comp &GetComponent(EntId id)
 	{
-		return m_EntityManager.GetComponent<Comp>(id);
+		Comp &component = m_EntityManager.GetComponent<Comp>(id);
+		m_EntityManager.Touch<Comp>(m_EntityManager.m_Entities[GetEntIndex(id)], m_EntityManager.GetIndex<Comp>(),
+			m_EntityManager.GetTick());
+		return component;
 	}
 
+	// Calls 'func(id, comps...)' for every entity with all of 'Comps'. Components listed as const
+	// are passed by const reference and only declared as read in 'GetAccess', the others are
+	// marked as changed for every entity visited.
 	template<typename... Comps, typename Func>
 	void View(const Func &func)
 	{
+		const size_t indices[] = { m_EntityManager.GetIndex<Comps>()... };
 		auto compMask = m_EntityManager.GetMask<Comps...>();
-		for (auto entity : m_EntityManager.m_Entities)
+
+		if constexpr ((IsSparseComponent<std::remove_const_t<Comps>>() || ...))
+		{
+			const SparsePool &pool = GetSmallestPool<Comps...>();
+			SparseRange<Comps...>(func, AcceptAll{}, compMask, indices, pool.GetIds().data(), pool.Size(),
+				std::index_sequence_for<Comps...>{});
+		}
+		else
 		{
-			if (compMask == (entity.Mask & compMask))
+			for (auto &archetype : m_EntityManager.m_Archetypes)
 			{
-				std::apply(func, std::tuple_cat(
-					std::make_tuple(entity.Id),
-					std::forward_as_tuple(m_EntityManager.GetComponent<Comps>(entity.Id)...)
-				));
+				if (archetype.Size() > 0 && compMask == (archetype.Mask & compMask))
+				{
+					TableRange<Comps...>(func, AcceptAll{}, archetype, 0, archetype.Size(), indices,
+						std::index_sequence_for<Comps...>{});
+				}
 			}
 		}
 	}
 
+	// Same as 'View' but splits the matching entities into chunks which are run across the job
+	// system. 'func' must be safe to call concurrently and must not change the registry.
+	template<typename... Comps, typename Func>
+	void ParallelView(const Func &func)
+	{
+		const size_t indices[] = { m_EntityManager.GetIndex<Comps>()... };
+		auto compMask = m_EntityManager.GetMask<Comps...>();
+
+		if constexpr ((IsSparseComponent<std::remove_const_t<Comps>>() || ...))
+		{
+			const SparsePool &pool = GetSmallestPool<Comps...>();
+			const uint32_t *ids = pool.GetIds().data();
+			JobSystem::ParallelFor(pool.Size(), k_ParallelChunkSize, [&](size_t begin, size_t end) {
+				SparseRange<Comps...>(func, AcceptAll{}, compMask, indices, ids + begin, end - begin,
+					std::index_sequence_for<Comps...>{});
+			});
+		}
+		else
+		{
+			std::vector<Archetype *> archetypes;
+			for (auto &archetype : m_EntityManager.m_Archetypes)
+			{
+				if (compMask == (archetype.Mask & compMask))
+				{
+					archetypes.push_back(&archetype);
+				}
+			}
+			ParallelTableRanges<Comps...>(func, AcceptAll{}, archetypes.data(), archetypes.size(), indices);
+		}
+	}
+
+	// Components a system reads and writes, const components are read only.
+	template<typename... Comps>
+	Access GetAccess()
+	{
+		Access access;
+		((std::is_const_v<Comps> ? access.Read : access.Write).set(m_EntityManager.GetIndex<Comps>()), ...);
+		return access;
+	}
+
 private:
 	Registry() = default;
 
-private:
-	EntityManager m_EntityManager;
-};
+	// Ranges only visit the rows or entities a filter accepts, views use this one to visit all.
+	struct AcceptAll
+	{
+		bool operator()(Archetype &archetype, size_t row) const { return true; }
+		bool operator()(const Entity &entity) const { return true; }
+	};
 
-template <typename T = uint32_t, std::size_t N>
-constexpr T StrHash(char const(&s)[N]) noexcept
-{
-	T val{};
-	for (size_t i = 0; i < N; ++i)
+	template<typename Comp>
+	static void TouchRow(Archetype &archetype, size_t index, size_t row, uint32_t tick)
+	{
+		if constexpr (!std::is_const_v<Comp>)
+		{
+			archetype.GetTicks(index)[row].Changed = tick;
+		}
+	}
+
+	template<typename... Comps, typename Func, typename Filter, size_t... I>
+	void TableRange(const Func &func, const Filter &filter, Archetype &archetype, size_t begin, size_t end,
+		const size_t *indices, std::index_sequence<I...>)
+	{
+		uint32_t tick = m_EntityManager.GetTick();
+		auto columns = std::make_tuple(archetype.GetColumn<Comps>(indices[I])...);
+		for (size_t row = begin; row < end; ++row)
+		{
+			if (filter(archetype, row))
+			{
+				(TouchRow<Comps>(archetype, indices[I], row, tick), ...);
+				func(archetype.Entities[row], std::get<I>(columns)[row]...);
+			}
+		}
+	}
+
+	// Splits the rows of 'archetypes' into chunks and runs them across the job system.
+	template<typename... Comps, typename Func, typename Filter>
+	void ParallelTableRanges(const Func &func, const Filter &filter, Archetype *const *archetypes, size_t count,
+		const size_t *indices)
+	{
+		struct Chunk
+		{
+			Archetype *Source;
+			size_t Begin, End;
+		};
+
+		std::vector<Chunk> chunks;
+		for (size_t i = 0; i < count; ++i)
+		{
+			Archetype &archetype = *archetypes[i];
+			for (size_t begin = 0; begin < archetype.Size(); begin += k_ParallelChunkSize)
+			{
+				chunks.push_back({ &archetype, begin, std::min(begin + k_ParallelChunkSize, archetype.Size()) });
+			}
+		}
+
+		JobSystem::ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+			{
+				TableRange<Comps...>(func, filter, *chunks[i].Source, chunks[i].Begin, chunks[i].End, indices,
+					std::index_sequence_for<Comps...>{});
+			}
+		});
+	}
+
+	// Views over sparse components iterate the smallest sparse pool densely and resolve the
+	// remaining components per entity.
+	template<typename... Comps, typename Func, typename Filter, size_t... I>
+	void SparseRange(const Func &func, const Filter &filter, const CompMask &compMask, const size_t *indices,
+		const uint32_t *ids, size_t count, std::index_sequence<I...>)
 	{
-		val |= s[i] << (i * CHAR_BIT);
+		uint32_t tick = m_EntityManager.GetTick();
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Entity &entity = m_EntityManager.m_Entities[ids[i]];
+			if (compMask == (entity.Mask & compMask) && filter(entity))
+			{
+				(m_EntityManager.Touch<Comps>(entity, indices[I], tick), ...);
+				func(entity.Id, m_EntityManager.Fetch<Comps>(entity, indices[I])...);
+			}
+		}
 	}
-	return val;
-}
+
+	template<typename... Comps>
+	const SparsePool &GetSmallestPool()
+	{
+		SparsePool *smallest = nullptr;
+		([&]() {
+			if constexpr (IsSparseComponent<std::remove_const_t<Comps>>())
+			{
+				SparsePool &pool = m_EntityManager.m_SparsePools[m_EntityManager.GetIndex<Comps>()];
+				if (!smallest || pool.Size() < smallest->Size())
+				{
+					smallest = &pool;
+				}
+			}
+		}(), ...);
+		return *smallest;
+	}
+
+private:
+	EntityManager m_EntityManager;
+};
 
 template<typename Comp>
 class ComponentRegisterer
@@ -86,7 +280,10 @@ public:
 
 #define DECL_COMPONENT(type)                                                                      \
 	template<> constexpr const char *GetComponentName<type>() { return #type; }                   \
-	template<> constexpr uint32_t GetComponentId<type>() { return StrHash(#type); }               \
 	static ComponentRegisterer<type> _RegisterComponent_##type;
 
+#define DECL_SPARSE_COMPONENT(type)                                                               \
+	template<> constexpr bool IsSparseComponent<type>() { return true; }                          \
+	DECL_COMPONENT(type)
+
 #include "game/Registration.hpp"
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "game/Query.hpp"
+#include "maths/AabbTree.hpp"
+
+#include <cstdint>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+//	SpatialIndex
+//
+//	AABB tree over every entity with a TransformComponent. 'Update' syncs it with the registry
+//	using change observers, so only entities whose transform changed are looked at. Of those, only
+//	entities which left their fat box are reinserted. Bounds are the sphere of radius |Scale|
+//	around the position, which holds the unit cube or quad at any rotation.
+//
+//	Queries only see what the last 'Update' saw, so update it after pending commands are applied
+//	and before querying, or destroyed entities are handed back.
+//-------------------------------------------------------------------------------------------------
+class SpatialIndex
+{
+public:
+	explicit SpatialIndex(float margin = 0.5f)
+		: m_Tree(margin)
+	{
+	}
+
+	void Update()
+	{
+		// Removals first, so a new entity reusing the index of a removed one finds its slot free.
+		m_Removed.Each([&](EntId id) {
+			uint32_t index = GetEntIndex(id);
+			if (index < m_Proxies.size() && m_Proxies[index] != AabbTree::k_Null
+				&& m_Tree.GetUserData(m_Proxies[index]) == id)
+			{
+				m_Tree.Remove(m_Proxies[index]);
+				m_Proxies[index] = AabbTree::k_Null;
+			}
+		});
+
+		m_Changed.Each([&](EntId id, const auto &transform) {
+			uint32_t index = GetEntIndex(id);
+			if (index >= m_Proxies.size())
+			{
+				m_Proxies.resize(index + 1, AabbTree::k_Null);
+			}
+
+			Aabb bounds = GetBounds(transform);
+			int32_t &proxy = m_Proxies[index];
+
+			if (proxy == AabbTree::k_Null)
+			{
+				proxy = m_Tree.Insert(bounds, id);
+			}
+			else
+			{
+				m_Tree.Move(proxy, bounds);
+			}
+		});
+	}
+
+	// Queries call 'func(EntId)' for each entity whose fat bounds pass the test.
+	template<typename Func>
+	void Query(const Aabb &aabb, Func &&func) const
+	{
+		m_Tree.Query(aabb, [&](uint32_t id) { func(static_cast<EntId>(id)); });
+	}
+
+	template<typename Func>
+	void Query(const Frustum &frustum, Func &&func) const
+	{
+		m_Tree.Query(frustum, [&](uint32_t id) { func(static_cast<EntId>(id)); });
+	}
+
+	template<typename Func>
+	void QuerySphere(glm::vec3 centre, float radius, Func &&func) const
+	{
+		m_Tree.QuerySphere(centre, radius, [&](uint32_t id) { func(static_cast<EntId>(id)); });
+	}
+
+	// Calls 'func(EntId, distance)' for each entity whose fat bounds the ray enters.
+	template<typename Func>
+	void Raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, Func &&func) const
+	{
+		m_Tree.Raycast(origin, direction, maxDistance, [&](uint32_t id, float distance) {
+			func(static_cast<EntId>(id), distance);
+		});
+	}
+
+	size_t Size() const { return m_Tree.Size(); }
+
+	static Aabb GetBounds(const TransformComponent &transform)
+	{
+		return Aabb::FromCentre(transform.Position, glm::vec3(glm::length(transform.Scale)));
+	}
+
+private:
+	AabbTree m_Tree;
+	// Proxy of each entity, by entity index.
+	std::vector<int32_t> m_Proxies;
+
+	OnChanged<const TransformComponent> m_Changed;
+	OnRemoved<TransformComponent> m_Removed;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "game/Query.hpp"
+#include "graphics/Renderer.hpp"
+
+//-------------------------------------------------------------------------------------------------
+//	StaticGeometry
+//
+//	Owns the renderer's static batch, holding every visible mesh flagged 'Static'. The batch is
+//	only rebuilt when a static mesh moved, or when any mesh was added, changed or removed, as that
+//	may have made it static or not. World transforms must be up to date beforehand.
+//-------------------------------------------------------------------------------------------------
+class StaticGeometry
+{
+public:
+	void Update()
+	{
+		bool dirty = !m_RemovedMeshes.Empty() || !m_RemovedTransforms.Empty();
+		m_RemovedMeshes.Each([](EntId id) {});
+		m_RemovedTransforms.Each([](EntId id) {});
+
+		m_ChangedMeshes.Each([&](EntId id, const auto &mesh, const auto &world) {
+			dirty = true;
+		});
+		m_Moved.Each([&](EntId id, const auto &world, const auto &mesh) {
+			dirty |= mesh.Static;
+		});
+
+		if (dirty)
+		{
+			Bake();
+		}
+	}
+
+private:
+	void Bake()
+	{
+		Renderer::BeginStaticBatch();
+		Registry::Get()->View<const WorldTransformComponent, const MeshComponent>([&](EntId id, const auto &world, const auto &mesh) {
+			if (mesh.Static && mesh.Visible)
+			{
+				Renderer::SubmitStaticCube(world.Matrix, mesh.Colour);
+			}
+		});
+		Renderer::EndStaticBatch();
+	}
+
+private:
+	OnChanged<const MeshComponent, const WorldTransformComponent> m_ChangedMeshes;
+	OnChanged<const WorldTransformComponent, const MeshComponent> m_Moved;
+	OnRemoved<MeshComponent> m_RemovedMeshes;
+	OnRemoved<WorldTransformComponent> m_RemovedTransforms;
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "game/CommandBuffer.hpp"
+#include "game/Registry.hpp"
+#include "util/JobSystem.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+//	SystemScheduler
+//
+//	Systems declare the components they read (const) and write. Each run a system depends on every
+//	earlier registered system it conflicts with, and systems whose dependencies have finished are
+//	run on the job system, so systems touching disjoint components overlap. Systems record
+//	structural changes into 'GetCommands()', which are applied once every system has finished.
+//-------------------------------------------------------------------------------------------------
+class SystemScheduler
+{
+public:
+	using SystemFunc = std::function<void(float dt)>;
+
+	template<typename... Comps>
+	void Add(const std::string &name, SystemFunc func)
+	{
+		m_Systems.push_back({ name, Registry::Get()->GetAccess<Comps...>(), std::move(func), false });
+	}
+
+	// For systems which must run on the thread calling 'Run', e.g. ones polling window input.
+	template<typename... Comps>
+	void AddMainThread(const std::string &name, SystemFunc func)
+	{
+		m_Systems.push_back({ name, Registry::Get()->GetAccess<Comps...>(), std::move(func), true });
+	}
+
+	CommandBuffer &GetCommands() { return m_Commands; }
+
+	void Run(float dt)
+	{
+		size_t count = m_Systems.size();
+
+		Frame frame;
+		frame.Dt = dt;
+		frame.Dependents.resize(count);
+		frame.Remaining = std::make_unique<std::atomic<size_t>[]>(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			frame.Remaining[i] = 0;
+			for (size_t j = 0; j < i; ++j)
+			{
+				if (m_Systems[j].SystemAccess.ConflictsWith(m_Systems[i].SystemAccess))
+				{
+					frame.Dependents[j].push_back(i);
+					frame.Remaining[i]++;
+				}
+			}
+		}
+
+		// Roots are collected up front as running systems already release their dependents.
+		std::vector<size_t> roots;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (frame.Remaining[i] == 0)
+			{
+				roots.push_back(i);
+			}
+		}
+		for (size_t root : roots)
+		{
+			Schedule(frame, root);
+		}
+
+		while (frame.Counter.Pending > 0)
+		{
+			size_t next = count;
+			{
+				std::lock_guard<std::mutex> lock(frame.MainThreadMutex);
+				if (!frame.MainThreadReady.empty())
+				{
+					next = frame.MainThreadReady.back();
+					frame.MainThreadReady.pop_back();
+				}
+			}
+
+			if (next != count)
+			{
+				Execute(frame, next);
+				frame.Counter.Pending--;
+			}
+			else if (!JobSystem::RunPending())
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		// No system is running, so entities and components can be created and destroyed safely.
+		m_Commands.Apply();
+	}
+
+private:
+	struct System
+	{
+		std::string Name;
+		Access SystemAccess;
+		SystemFunc Func;
+		bool MainThread;
+	};
+
+	struct Frame
+	{
+		float Dt;
+		std::vector<std::vector<size_t>> Dependents;
+		std::unique_ptr<std::atomic<size_t>[]> Remaining;
+		JobCounter Counter;
+
+		std::mutex MainThreadMutex;
+		std::vector<size_t> MainThreadReady;
+	};
+
+	void Schedule(Frame &frame, size_t system)
+	{
+		if (m_Systems[system].MainThread)
+		{
+			frame.Counter.Pending++;
+			std::lock_guard<std::mutex> lock(frame.MainThreadMutex);
+			frame.MainThreadReady.push_back(system);
+		}
+		else
+		{
+			JobSystem::Dispatch(frame.Counter, [this, &frame, system]() {
+				Execute(frame, system);
+			});
+		}
+	}
+
+	void Execute(Frame &frame, size_t system)
+	{
+		m_Systems[system].Func(frame.Dt);
+		for (size_t dependent : frame.Dependents[system])
+		{
+			if (--frame.Remaining[dependent] == 0)
+			{
+				Schedule(frame, dependent);
+			}
+		}
+	}
+
+private:
+	std::vector<System> m_Systems;
+	CommandBuffer m_Commands;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "game/Query.hpp"
+#include "maths/Algebra.hpp"
+
+//-------------------------------------------------------------------------------------------------
+//	Transforms
+//
+//	Brings every WorldTransformComponent up to date with its TransformComponent. Only entities
+//	whose transform changed, or which just got a world transform, since the last update are
+//	visited, static entities cost nothing.
+//-------------------------------------------------------------------------------------------------
+inline void UpdateWorldTransforms()
+{
+	static OnChanged<const TransformComponent, WorldTransformComponent> s_Moved;
+	static OnAdded<WorldTransformComponent, const TransformComponent> s_Added;
+
+	s_Moved.ParallelEach([](EntId id, const auto &transform, auto &world) {
+		world.Matrix = MakeTransform(transform.Position, transform.Scale, transform.Rotation);
+	});
+	s_Added.Each([](EntId id, auto &world, const auto &transform) {
+		world.Matrix = MakeTransform(transform.Position, transform.Scale, transform.Rotation);
+	});
+}
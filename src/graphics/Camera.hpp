@@ -1,5 +1,7 @@
 #pragma once
 
+#include "maths/Frustum.hpp"
+
 #include <glm/glm.hpp>
 #include <glm/gtx/euler_angles.hpp>
 
@@ -47,6 +49,11 @@ public:
 		return m_Perspective;
 	}
 
+	Frustum GetFrustum() const
+	{
+		return Frustum(m_Perspective * m_View);
+	}
+
 private:
 	float m_Fov, m_Aspect, m_Near, m_Far;
 	glm::mat4 m_View, m_Perspective;
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "maths/Frustum.hpp"
+#include "util/JobSystem.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+//	CullList
+//
+//	Collects render items with a bounding sphere each frame, then hands back only those inside a
+//	frustum. Spheres are kept as separate streams so they are tested four at a time.
+//-------------------------------------------------------------------------------------------------
+template<typename Item>
+class CullList
+{
+	static constexpr size_t k_ParallelChunkSize = 1024;
+
+public:
+	// Most items handed to 'ParallelForEachVisibleBatch' callbacks at once.
+	static constexpr size_t k_BatchSize = 64;
+
+	void Clear()
+	{
+		m_X.clear();
+		m_Y.clear();
+		m_Z.clear();
+		m_Radius.clear();
+		m_Items.clear();
+	}
+
+	void Add(glm::vec3 centre, float radius, const Item &item)
+	{
+		m_X.push_back(centre.x);
+		m_Y.push_back(centre.y);
+		m_Z.push_back(centre.z);
+		m_Radius.push_back(radius);
+		m_Items.push_back(item);
+	}
+
+	// Calls 'func' with each item whose bounding sphere intersects 'frustum'.
+	template<typename Func>
+	void ForEachVisible(const Frustum &frustum, Func &&func)
+	{
+		m_Visible.resize(m_Items.size());
+		frustum.Intersects(m_X.data(), m_Y.data(), m_Z.data(), m_Radius.data(), m_Items.size(), m_Visible.data());
+
+		for (size_t i = 0; i < m_Items.size(); ++i)
+		{
+			if (m_Visible[i])
+			{
+				func(m_Items[i]);
+			}
+		}
+	}
+
+	// Same as 'ForEachVisible', but tests and visits chunks of items across the job system's
+	// threads, so 'func' must be safe to call concurrently.
+	template<typename Func>
+	void ParallelForEachVisible(const Frustum &frustum, Func &&func)
+	{
+		m_Visible.resize(m_Items.size());
+		JobSystem::ParallelFor(m_Items.size(), k_ParallelChunkSize, [&](size_t begin, size_t end) {
+			frustum.Intersects(m_X.data() + begin, m_Y.data() + begin, m_Z.data() + begin, m_Radius.data() + begin,
+				end - begin, m_Visible.data() + begin);
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				if (m_Visible[i])
+				{
+					func(m_Items[i]);
+				}
+			}
+		});
+	}
+
+	// Same as 'ParallelForEachVisible', but packs the visible items and calls 'func(items, count)'
+	// with up to 'k_BatchSize' of them at a time, so they can be submitted as a batch.
+	template<typename Func>
+	void ParallelForEachVisibleBatch(const Frustum &frustum, Func &&func)
+	{
+		m_Visible.resize(m_Items.size());
+		JobSystem::ParallelFor(m_Items.size(), k_ParallelChunkSize, [&](size_t begin, size_t end) {
+			frustum.Intersects(m_X.data() + begin, m_Y.data() + begin, m_Z.data() + begin, m_Radius.data() + begin,
+				end - begin, m_Visible.data() + begin);
+
+			const Item *batch[k_BatchSize];
+			size_t count = 0;
+			for (size_t i = begin; i < end; ++i)
+			{
+				if (m_Visible[i])
+				{
+					batch[count++] = &m_Items[i];
+					if (count == k_BatchSize)
+					{
+						func(batch, count);
+						count = 0;
+					}
+				}
+			}
+			if (count > 0)
+			{
+				func(batch, count);
+			}
+		});
+	}
+
+	size_t Size() const { return m_Items.size(); }
+
+private:
+	std::vector<float> m_X, m_Y, m_Z, m_Radius;
+	std::vector<Item> m_Items;
+	std::vector<uint8_t> m_Visible;
+};
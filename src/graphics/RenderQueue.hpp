@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+//	RenderQueue
+//
+//	Draw commands recorded during a scene, each a 64 bit sort key and the index of its payload in
+//	whatever array the renderer keeps for that kind of command. Sorting by key groups commands
+//	which share state so they merge into one draw, and orders them by depth within each group.
+//
+//	Keys, from the most significant bit:
+//		opaque		| layer:4 | 0 | shader:4 | material:8 | depth:32         | 0:15 |
+//		translucent	| layer:4 | 1 | ~depth:32         | shader:4 | material:8 | 0:15 |
+//	Opaque commands sort by state, then front to back to make the most of early depth tests.
+//	Translucent commands must blend back to front, so depth comes first and state second.
+//-------------------------------------------------------------------------------------------------
+struct RenderCommand
+{
+	uint64_t Key;
+	uint32_t Payload;
+};
+
+class RenderQueue
+{
+public:
+	static constexpr uint32_t k_MaxLayers = 16;
+	static constexpr uint32_t k_MaxShaders = 16;
+	static constexpr uint32_t k_MaxMaterials = 256;
+
+	// 'depth' is the view space distance along the camera axis, anything behind the camera sorts as 0.
+	static uint64_t MakeKey(uint32_t layer, bool translucent, uint32_t shader, uint32_t material, float depth)
+	{
+		// Bits of a non negative float sort the same way as its value.
+		uint32_t depthBits;
+		float clamped = std::max(depth, 0.0f);
+		std::memcpy(&depthBits, &clamped, sizeof(depthBits));
+
+		uint64_t state = (uint64_t(shader & (k_MaxShaders - 1)) << 8) | (material & (k_MaxMaterials - 1));
+		uint64_t key = uint64_t(layer & (k_MaxLayers - 1)) << 60;
+
+		if (translucent)
+		{
+			key |= uint64_t(1) << 59;
+			key |= uint64_t(~depthBits) << 27;
+			key |= state << 15;
+		}
+		else
+		{
+			key |= state << 47;
+			key |= uint64_t(depthBits) << 15;
+		}
+		return key;
+	}
+
+	static bool IsTranslucent(uint64_t key) { return (key >> 59) & 1; }
+
+	// Shader and material, which together decide whether two commands can share a draw.
+	static uint32_t GetState(uint64_t key)
+	{
+		return static_cast<uint32_t>(IsTranslucent(key) ? (key >> 15) & 0xFFF : (key >> 47) & 0xFFF);
+	}
+	static uint32_t GetShader(uint64_t key) { return GetState(key) >> 8; }
+	static uint32_t GetMaterial(uint64_t key) { return GetState(key) & 0xFF; }
+
+	void Clear() { m_Commands.clear(); }
+
+	void Push(uint64_t key, uint32_t payload) { m_Commands.push_back({ key, payload }); }
+
+	// Stable LSD radix sort, 8 bits per pass. Passes where every key has the same byte are skipped,
+	// which with the unused low bits and few layers and states is most of them.
+	void Sort()
+	{
+		size_t count = m_Commands.size();
+		m_Scratch.resize(count);
+
+		std::array<std::array<uint32_t, 256>, 8> histograms{};
+		for (const auto &command : m_Commands)
+		{
+			for (size_t pass = 0; pass < 8; ++pass)
+			{
+				histograms[pass][(command.Key >> (pass * 8)) & 0xFF]++;
+			}
+		}
+
+		RenderCommand *source = m_Commands.data();
+		RenderCommand *destination = m_Scratch.data();
+
+		for (size_t pass = 0; pass < 8; ++pass)
+		{
+			auto &histogram = histograms[pass];
+			size_t shift = pass * 8;
+
+			if (count == 0 || histogram[(source[0].Key >> shift) & 0xFF] == count)
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (auto &bucket : histogram)
+			{
+				uint32_t size = bucket;
+				bucket = offset;
+				offset += size;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				destination[histogram[(source[i].Key >> shift) & 0xFF]++] = source[i];
+			}
+			std::swap(source, destination);
+		}
+
+		if (source != m_Commands.data())
+		{
+			m_Commands.swap(m_Scratch);
+		}
+	}
+
+	const RenderCommand *begin() const { return m_Commands.data(); }
+	const RenderCommand *end() const { return m_Commands.data() + m_Commands.size(); }
+	size_t Size() const { return m_Commands.size(); }
+
+private:
+	std::vector<RenderCommand> m_Commands;
+	std::vector<RenderCommand> m_Scratch;
+};
@@ -1,314 +1,1150 @@
-#include "Renderer.hpp"
-
-#include "util/Log.h"
-#include "util/File.hpp"
-
-#include <glad/glad.h>
-#include <glm/ext.hpp>
-
-static constexpr size_t k_MaxVertices = 64 * 1024;
-
-struct Vertex
-{
-	glm::vec3 Position;
-	glm::vec3 Normal;
-	glm::vec4 Colour;
-};
-
-struct BatchRendererData
-{
-	GLuint Program;
-	GLuint Vao, Vbo;
-	Vertex *BatchDataPtr;
-	GLsizei VerticesCount;
-
-	BatchRendererData()
-		: Program(0), Vao(0), Vbo(0), BatchDataPtr(nullptr), VerticesCount(0)
-	{
-	}
-};
-
-static BatchRendererData s_RendererData;
-
-void Renderer::InitRenderer()
-{
-	auto vertexSrcRawOpt = ReadFile("basic.vertex");
-	auto fragmentSrcRawOpt = ReadFile("basic.fragment");
-	ASSERT(vertexSrcRawOpt, "Could not load vertex shader source!");
-	ASSERT(fragmentSrcRawOpt, "Could not load fragment shader source!");
-
-	auto vertexSrcRaw = vertexSrcRawOpt.value();
-	auto fragmentSrcRaw = fragmentSrcRawOpt.value();
-	auto vertexSrcStr = std::string(vertexSrcRaw.begin(), vertexSrcRaw.end());
-	auto fragmentSrcStr = std::string(fragmentSrcRaw.begin(), fragmentSrcRaw.end());
-
-	const char *vertexSrc = vertexSrcStr.c_str();
-	const char *fragmentSrc = fragmentSrcStr.c_str();
-
-	int success;
-	char infoLog[1024];
-
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexSrc, NULL);
-	glCompileShader(vertexShader);
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(vertexShader, 1024, NULL, infoLog);
-		LOG("Vertex shader failed to compile!\n%s", infoLog);
-	}
-
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentSrc, NULL);
-	glCompileShader(fragmentShader);
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(fragmentShader, 1024, NULL, infoLog);
-		LOG("Fragment shader failed to compile!\n%s", infoLog);
-	}
-
-	s_RendererData.Program = glCreateProgram();
-	glAttachShader(s_RendererData.Program, vertexShader);
-	glAttachShader(s_RendererData.Program, fragmentShader);
-	glLinkProgram(s_RendererData.Program);
-
-	glDetachShader(s_RendererData.Program, vertexShader);
-	glDetachShader(s_RendererData.Program, fragmentShader);
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-	glGenVertexArrays(1, &s_RendererData.Vao);
-	glGenBuffers(1, &s_RendererData.Vbo);
-
-	glBindVertexArray(s_RendererData.Vao);
-	glBindBuffer(GL_ARRAY_BUFFER, s_RendererData.Vbo);
-
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * k_MaxVertices, (GLvoid *)0, GL_DYNAMIC_DRAW);
-
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)0);
-
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)(3 * sizeof(float)));
-
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)(6 * sizeof(float)));
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-
-	MapBuffer();
-}
-
-void Renderer::CleanupRenderer()
-{
-	UnmapBuffer();
-
-	glDeleteProgram(s_RendererData.Program);
-	glDeleteBuffers(1, &s_RendererData.Vbo);
-	glDeleteVertexArrays(1, &s_RendererData.Vao);
-}
-
-void Renderer::FlushVertices()
-{
-	if (s_RendererData.VerticesCount == 0)
-	{
-		return;
-	}
-
-	UnmapBuffer();
-
-	glUseProgram(s_RendererData.Program);
-	glDrawArrays(GL_TRIANGLES, 0, s_RendererData.VerticesCount);
-	glUseProgram(0);
-
-	s_RendererData.VerticesCount = 0;
-
-	MapBuffer();
-}
-
-void Renderer::FlushScene()
-{
-	FlushVertices();
-}
-
-void Renderer::MapBuffer()
-{
-	glBindBuffer(GL_ARRAY_BUFFER, s_RendererData.Vbo);
-	s_RendererData.BatchDataPtr = (Vertex *)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-}
-
-void Renderer::UnmapBuffer()
-{
-	glBindBuffer(GL_ARRAY_BUFFER, s_RendererData.Vbo);
-	glUnmapBuffer(GL_ARRAY_BUFFER);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-}
-
-void Renderer::Init()
-{
-	InitRenderer();
-
-	glClearColor(0.2f, 0.5f, 0.7f, 1.0f);
-
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-	glEnable(GL_DEPTH_TEST);
-}
-
-void Renderer::Terminate()
-{
-	CleanupRenderer();
-}
-
-void Renderer::SetViewportSize(int width, int height)
-{
-	glViewport(0, 0, width, height);
-}
-
-void Renderer::BeginScene(const RenderContext &context)
-{
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	glm::mat4 viewMatrix = context.camera->GetViewMatrix();
-	glm::mat4 profMatrix = context.camera->GetProjMatrix();
-
-	glUseProgram(s_RendererData.Program);
-
-	GLint loc;
-	loc = glGetUniformLocation(s_RendererData.Program, "u_View");
-	glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-	loc = glGetUniformLocation(s_RendererData.Program, "u_Proj");
-	glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(profMatrix));
-	glUseProgram(0);
-
-	glBindVertexArray(s_RendererData.Vao);
-}
-
-void Renderer::EndScene()
-{
-	FlushScene();
-
-	glBindVertexArray(0);
-}
-
-void Renderer::SubmitTriangle(const std::array<glm::vec3, 3> &vertices, glm::vec4 colour)
-{
-	if (s_RendererData.VerticesCount + 3 > k_MaxVertices)
-	{
-		FlushVertices();
-	}
-
-	glm::vec3 normal = glm::normalize(glm::cross(
-		vertices[1] - vertices[0],
-		vertices[2] - vertices[0]
-	));
-
-	s_RendererData.BatchDataPtr->Position = vertices[0];
-	s_RendererData.BatchDataPtr->Normal = normal;
-	s_RendererData.BatchDataPtr->Colour = colour;
-
-	s_RendererData.BatchDataPtr++;
-
-	s_RendererData.BatchDataPtr->Position = vertices[1];
-	s_RendererData.BatchDataPtr->Normal = normal;
-	s_RendererData.BatchDataPtr->Colour = colour;
-
-	s_RendererData.BatchDataPtr++;
-
-	s_RendererData.BatchDataPtr->Position = vertices[2];
-	s_RendererData.BatchDataPtr->Normal = normal;
-	s_RendererData.BatchDataPtr->Colour = colour;
-
-	s_RendererData.BatchDataPtr++;
-
-	s_RendererData.VerticesCount += 3;
-}
-
-void Renderer::SubmitQuad(const std::array<glm::vec3, 4> &vertices, glm::vec4 colour)
-{
-	if (s_RendererData.VerticesCount + 2 * 3 > k_MaxVertices)
-	{
-		FlushVertices();
-	}
-
-	Renderer::SubmitTriangle(
-		{ vertices[0], vertices[1], vertices[2] },
-		colour
-	);
-	Renderer::SubmitTriangle(
-		{ vertices[2], vertices[1], vertices[3] },
-		colour
-	);
-}
-
-void Renderer::SubmitCube(const std::array<glm::vec3, 8> &vertices, glm::vec4 colour)
-{
-	if (s_RendererData.VerticesCount + 2 * 6 * 3 > k_MaxVertices)
-	{
-		FlushVertices();
-	}
-
-	// Front
-	Renderer::SubmitTriangle(
-		{ vertices[0], vertices[1], vertices[2] },
-		colour
-	);
-	Renderer::SubmitTriangle(
-		{ vertices[2], vertices[1], vertices[3] },
-		colour
-	);
-
-	// Back
-	Renderer::SubmitTriangle(
-		{ vertices[6], vertices[7], vertices[4] },
-		colour
-	);
-	Renderer::SubmitTriangle(
-		{ vertices[4], vertices[7], vertices[5] },
-		colour
-	);
-
-	// Left
-	Renderer::SubmitTriangle(
-		{ vertices[4], vertices[5], vertices[0] },
-		colour
-	);
-	Renderer::SubmitTriangle(
-		{ vertices[0], vertices[5], vertices[1] },
-		colour
-	);
-
-	// Right
-	Renderer::SubmitTriangle(
-		{ vertices[2], vertices[3], vertices[6] },
-		colour
-	);
-	Renderer::SubmitTriangle(
-		{ vertices[6], vertices[3], vertices[7] },
-		colour
-	);
-
-	// Top
-	Renderer::SubmitTriangle(
-		{ vertices[4], vertices[0], vertices[6] },
-		colour
-	);
-	Renderer::SubmitTriangle(
-		{ vertices[6], vertices[0], vertices[2] },
-		colour
-	);
-
-	// Bottom
-	Renderer::SubmitTriangle(
-		{ vertices[1], vertices[5], vertices[3] },
-		colour
-	);
-	Renderer::SubmitTriangle(
-		{ vertices[3], vertices[5], vertices[7] },
-		colour
-	);
-}
\ No newline at end of file
+#include "Renderer.hpp"
+#include "StreamBuffer.hpp"
+
+#include "util/Log.h"
+#include "util/File.hpp"
+#include "util/JobSystem.hpp"
+#include "maths/Algebra.hpp"
+
+#include <glad/glad.h>
+#include <glm/ext.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Batch indices are 16 bit and relative to the start of each draw.
+static constexpr size_t k_MaxVertices = 64 * 1024;
+static constexpr size_t k_MaxIndices = k_MaxVertices * 3 / 2;
+// A cube, the largest primitive the batch draws.
+static constexpr size_t k_MaxPrimitiveVertices = 6 * 4;
+static constexpr size_t k_MaxPrimitiveIndices = 6 * 6;
+// Stream buffer regions start out holding this many per frame and grow if a frame needs more.
+static constexpr size_t k_MaxInstances = 16 * 1024;
+static constexpr size_t k_MaxParticles = 16 * 1024;
+
+// Corners of the unit cube and quad, in the order 'MakeCubeVertices' and 'MakeQuadVertices' return them.
+static const glm::vec3 k_UnitCube[8] = {
+	{ -1.0f, -1.0f, 1.0f }, { -1.0f, 1.0f, 1.0f }, { 1.0f, -1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f },
+	{ -1.0f, -1.0f, -1.0f }, { -1.0f, 1.0f, -1.0f }, { 1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, -1.0f }
+};
+static const glm::vec3 k_UnitQuad[4] = {
+	{ -1.0f, -1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }
+};
+
+// Faces share their four vertices between two triangles, see 'k_FaceIndices'.
+static constexpr uint8_t k_CubeFaces[6][4] = {
+	{ 0, 1, 2, 3 }, // Front
+	{ 6, 7, 4, 5 }, // Back
+	{ 4, 5, 0, 1 }, // Left
+	{ 2, 3, 6, 7 }, // Right
+	{ 4, 0, 6, 2 }, // Top
+	{ 1, 5, 3, 7 }  // Bottom
+};
+static constexpr uint8_t k_QuadFaces[1][4] = {
+	{ 0, 1, 2, 3 }
+};
+static constexpr uint8_t k_FaceIndices[6] = { 0, 1, 2, 2, 1, 3 };
+
+#if ENABLE_COMPACT_VERTICES
+// Normal as signed normalized GL_INT_2_10_10_10_REV, colour as unsigned normalized RGBA8.
+using VertexNormal = uint32_t;
+using VertexColour = uint32_t;
+
+static VertexNormal PackNormal(glm::vec3 normal)
+{
+	auto pack = [](float value) {
+		return static_cast<uint32_t>(static_cast<int32_t>(std::round(glm::clamp(value, -1.0f, 1.0f) * 511.0f)) & 0x3FF);
+	};
+	return pack(normal.x) | (pack(normal.y) << 10) | (pack(normal.z) << 20);
+}
+
+static VertexColour PackColour(glm::vec4 colour)
+{
+	auto pack = [](float value) {
+		return static_cast<uint32_t>(std::round(glm::clamp(value, 0.0f, 1.0f) * 255.0f));
+	};
+	return pack(colour.r) | (pack(colour.g) << 8) | (pack(colour.b) << 16) | (pack(colour.a) << 24);
+}
+#else
+using VertexNormal = glm::vec3;
+using VertexColour = glm::vec4;
+
+static VertexNormal PackNormal(glm::vec3 normal) { return normal; }
+static VertexColour PackColour(glm::vec4 colour) { return colour; }
+#endif
+
+struct Vertex
+{
+	glm::vec3 Position;
+	VertexNormal Normal;
+	VertexColour Colour;
+};
+
+struct MeshVertex
+{
+	glm::vec3 Position;
+	glm::vec3 Normal;
+};
+
+struct MeshInstance
+{
+	glm::mat4 Transform;
+	glm::vec4 Colour;
+};
+
+enum InstancedMesh
+{
+	CubeMesh, QuadMesh,
+	MeshCount
+};
+
+// Programs as they appear in sort keys, instanced commands use their mesh as material.
+enum RenderShader
+{
+	BatchShader, InstanceShader
+};
+
+struct BatchRendererData
+{
+	GLuint Program;
+	GLuint Vao;
+	StreamBuffer Vbo, Ibo;
+	Vertex *BatchDataPtr;
+	GLushort *IndexDataPtr;
+	GLsizei VerticesCount;
+	GLsizei IndicesCount;
+	// First vertex of the open draw, its indices are relative to it.
+	GLsizei DrawVertex;
+	// Room left at the stream buffers' write cursors.
+	size_t VerticesCapacity;
+	size_t IndicesCapacity;
+
+	BatchRendererData()
+		: Program(0), Vao(0), BatchDataPtr(nullptr), IndexDataPtr(nullptr), VerticesCount(0), IndicesCount(0)
+		, DrawVertex(0), VerticesCapacity(0), IndicesCapacity(0)
+	{
+	}
+};
+
+// One per instanced mesh, each draws a range of the shared static index buffer.
+struct InstanceBatch
+{
+	GLuint Vao;
+	StreamBuffer Vbo;
+	size_t First;
+	GLsizei Count;
+	MeshInstance *InstanceDataPtr;
+	GLsizei InstancesCount;
+	size_t InstancesCapacity;
+
+	InstanceBatch()
+		: Vao(0), First(0), Count(0), InstanceDataPtr(nullptr), InstancesCount(0), InstancesCapacity(0)
+	{
+	}
+};
+
+struct InstanceRendererData
+{
+	GLuint Program;
+	GLuint MeshVbo, MeshIbo;
+	std::array<InstanceBatch, MeshCount> Batches;
+
+	InstanceRendererData()
+		: Program(0), MeshVbo(0), MeshIbo(0)
+	{
+	}
+};
+
+// Cube instances retained on the GPU, only uploaded when the batch is rebuilt.
+struct StaticBatchData
+{
+	GLuint Vao, Vbo;
+	GLsizei InstancesCount;
+	std::vector<MeshInstance> Instances;
+
+	StaticBatchData()
+		: Vao(0), Vbo(0), InstancesCount(0)
+	{
+	}
+};
+
+struct ParticleRendererData
+{
+	GLuint Program;
+	GLuint Vao, QuadVbo;
+	StreamBuffer InstanceVbo;
+	ParticleInstance *InstanceDataPtr;
+	GLsizei InstancesCount;
+	size_t InstancesCapacity;
+
+	ParticleRendererData()
+		: Program(0), Vao(0), QuadVbo(0), InstanceDataPtr(nullptr), InstancesCount(0), InstancesCapacity(0)
+	{
+	}
+};
+
+// Triangle, quad or cube submitted to the batch, its 3, 4 or 8 corners are in 'SceneData::Positions'.
+struct BatchPrimitive
+{
+	uint32_t First;
+	uint32_t Count;
+	glm::vec4 Colour;
+};
+
+// Everything one thread submitted since 'BeginScene', command payloads index 'Primitives' or
+// 'Instances'. Each submission writes the queue's and one array's end pointers, so the contexts
+// of neighbouring threads are kept on separate cache lines.
+struct alignas(64) SubmitContext
+{
+	RenderQueue Queue;
+	std::vector<glm::vec3> Positions;
+	std::vector<BatchPrimitive> Primitives;
+	std::vector<MeshInstance> Instances;
+	uint32_t Layer;
+
+	SubmitContext()
+		: Layer(0)
+	{
+	}
+};
+
+// Draw of a run, or part of one, from a sub-range of the data written to the stream buffers since
+// they were last mapped. 'First' and 'Count' are indices for the batch and instances otherwise.
+struct RunDraw
+{
+	bool Translucent;
+	uint32_t Shader;
+	uint32_t Mesh;
+	GLsizei First;
+	GLsizei Count;
+	GLint BaseVertex;
+};
+
+// One context per job system thread, indexed by 'JobSystem::GetThreadIndex'. Workers fill theirs
+// without locking and 'EndScene' merges them all into the main thread's one before sorting.
+struct SceneData
+{
+	std::vector<SubmitContext> Contexts;
+	glm::mat4 View;
+
+	// Draws whose data is written but not yet issued, the last one still growing if 'DrawOpen'.
+	std::vector<RunDraw> Draws;
+	bool DrawOpen;
+
+	SceneData()
+		: View(1.0f), DrawOpen(false)
+	{
+	}
+};
+
+// GL state last set by the renderer, so runs which share it skip the calls.
+struct RenderState
+{
+	GLuint Program;
+	GLuint Vao;
+	bool Translucent;
+
+	RenderState()
+		: Program(0), Vao(0), Translucent(false)
+	{
+	}
+};
+
+static BatchRendererData s_RendererData;
+static InstanceRendererData s_InstanceData;
+static StaticBatchData s_StaticData;
+static ParticleRendererData s_ParticleData;
+static SceneData s_SceneData;
+static RenderState s_RenderState;
+
+static glm::vec3 TriangleNormal(glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+	return glm::normalize(glm::cross(b - a, c - a));
+}
+
+template<size_t Faces>
+static void AppendMesh(std::vector<MeshVertex> &vertices, std::vector<GLushort> &indices, const glm::vec3 *corners, const uint8_t (&faces)[Faces][4])
+{
+	for (const auto &face : faces)
+	{
+		glm::vec3 normal = TriangleNormal(corners[face[0]], corners[face[1]], corners[face[2]]);
+		GLushort base = static_cast<GLushort>(vertices.size());
+		for (uint8_t corner : face)
+		{
+			vertices.push_back({ corners[corner], normal });
+		}
+		for (uint8_t index : k_FaceIndices)
+		{
+			indices.push_back(base + index);
+		}
+	}
+}
+
+// Appends a flat shaded triangle to the batch, the caller must have made room for 3 vertices and indices.
+static void AppendTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec4 colour)
+{
+	VertexNormal normal = PackNormal(TriangleNormal(a, b, c));
+	VertexColour packedColour = PackColour(colour);
+	GLushort base = static_cast<GLushort>(s_RendererData.VerticesCount - s_RendererData.DrawVertex);
+
+	for (glm::vec3 position : { a, b, c })
+	{
+		s_RendererData.BatchDataPtr->Position = position;
+		s_RendererData.BatchDataPtr->Normal = normal;
+		s_RendererData.BatchDataPtr->Colour = packedColour;
+
+		s_RendererData.BatchDataPtr++;
+		*s_RendererData.IndexDataPtr++ = base++;
+	}
+
+	s_RendererData.VerticesCount += 3;
+	s_RendererData.IndicesCount += 3;
+}
+
+// Appends a flat shaded face to the batch, the caller must have made room for 4 vertices and 6 indices.
+static void AppendFace(glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d, glm::vec4 colour)
+{
+	VertexNormal normal = PackNormal(TriangleNormal(a, b, c));
+	VertexColour packedColour = PackColour(colour);
+	GLushort base = static_cast<GLushort>(s_RendererData.VerticesCount - s_RendererData.DrawVertex);
+
+	for (glm::vec3 position : { a, b, c, d })
+	{
+		s_RendererData.BatchDataPtr->Position = position;
+		s_RendererData.BatchDataPtr->Normal = normal;
+		s_RendererData.BatchDataPtr->Colour = packedColour;
+
+		s_RendererData.BatchDataPtr++;
+	}
+
+	for (uint8_t index : k_FaceIndices)
+	{
+		*s_RendererData.IndexDataPtr++ = base + index;
+	}
+
+	s_RendererData.VerticesCount += 4;
+	s_RendererData.IndicesCount += 6;
+}
+
+static void BindState(GLuint program, GLuint vao)
+{
+	if (s_RenderState.Program != program)
+	{
+		glUseProgram(program);
+		s_RenderState.Program = program;
+	}
+	if (s_RenderState.Vao != vao)
+	{
+		glBindVertexArray(vao);
+		s_RenderState.Vao = vao;
+	}
+}
+
+// Translucent geometry is blended and tested against depth without writing it, so it never hides
+// what is drawn behind it later.
+static void SetTranslucent(bool translucent)
+{
+	if (s_RenderState.Translucent == translucent)
+	{
+		return;
+	}
+
+	if (translucent)
+	{
+		glEnable(GL_BLEND);
+		glDepthMask(GL_FALSE);
+	}
+	else
+	{
+		glDisable(GL_BLEND);
+		glDepthMask(GL_TRUE);
+	}
+	s_RenderState.Translucent = translucent;
+}
+
+static SubmitContext &GetSubmitContext()
+{
+	size_t thread = JobSystem::GetThreadIndex();
+	ASSERT(thread < s_SceneData.Contexts.size(), "Submitting from a thread the renderer has no context for !");
+	return s_SceneData.Contexts[thread];
+}
+
+// Appends the submissions of every worker context to the main thread's, rebasing their indices.
+static void MergeSubmitContexts()
+{
+	SubmitContext &main = s_SceneData.Contexts[0];
+
+	for (size_t thread = 1; thread < s_SceneData.Contexts.size(); ++thread)
+	{
+		SubmitContext &context = s_SceneData.Contexts[thread];
+		if (context.Queue.Size() == 0)
+		{
+			continue;
+		}
+
+		uint32_t positionOffset = static_cast<uint32_t>(main.Positions.size());
+		uint32_t primitiveOffset = static_cast<uint32_t>(main.Primitives.size());
+		uint32_t instanceOffset = static_cast<uint32_t>(main.Instances.size());
+
+		main.Positions.insert(main.Positions.end(), context.Positions.begin(), context.Positions.end());
+		for (const BatchPrimitive &primitive : context.Primitives)
+		{
+			main.Primitives.push_back({ primitive.First + positionOffset, primitive.Count, primitive.Colour });
+		}
+		main.Instances.insert(main.Instances.end(), context.Instances.begin(), context.Instances.end());
+
+		for (const RenderCommand &command : context.Queue)
+		{
+			bool batch = RenderQueue::GetShader(command.Key) == BatchShader;
+			main.Queue.Push(command.Key, command.Payload + (batch ? primitiveOffset : instanceOffset));
+		}
+
+		context.Queue.Clear();
+		context.Positions.clear();
+		context.Primitives.clear();
+		context.Instances.clear();
+	}
+}
+
+// Distance in front of the camera along its view axis.
+static float ViewDepth(glm::vec3 position)
+{
+	const glm::mat4 &view = s_SceneData.View;
+	return -(view[0][2] * position.x + view[1][2] * position.y + view[2][2] * position.z + view[3][2]);
+}
+
+// Points the instance attributes of the bound vertex array at the MeshInstances from 'offset'.
+// Instanced attributes have no base instance before GL 4.2, so this is redone per draw region.
+static void SetInstanceAttributes(GLuint buffer, size_t offset)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (GLuint column = 0; column < 4; ++column)
+	{
+		// A mat4 attribute takes up four consecutive locations, one per column.
+		glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+			(GLvoid *)(offset + offsetof(MeshInstance, Transform) + sizeof(glm::vec4) * column));
+	}
+	glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(MeshInstance), (GLvoid *)(offset + offsetof(MeshInstance, Colour)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Points the bound batch vertex array at the stream buffers, which are renamed when a frame
+// begins by growing them.
+static void SetBatchAttributes()
+{
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_RendererData.Ibo.GetBuffer());
+	glBindBuffer(GL_ARRAY_BUFFER, s_RendererData.Vbo.GetBuffer());
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, Position));
+
+#if ENABLE_COMPACT_VERTICES
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, Normal));
+
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, Colour));
+#else
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, Normal));
+
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, Colour));
+#endif
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Map the space left at each stream buffer's write cursor for the next draw's data.
+static void BeginVertices()
+{
+	auto &data = s_RendererData;
+	data.BatchDataPtr = (Vertex *)data.Vbo.Begin(sizeof(Vertex) * k_MaxPrimitiveVertices);
+	data.IndexDataPtr = (GLushort *)data.Ibo.Begin(sizeof(GLushort) * k_MaxPrimitiveIndices);
+	data.VerticesCapacity = data.Vbo.GetAvailable() / sizeof(Vertex);
+	data.IndicesCapacity = data.Ibo.GetAvailable() / sizeof(GLushort);
+}
+
+static void BeginInstances(InstanceBatch &batch)
+{
+	batch.InstanceDataPtr = (MeshInstance *)batch.Vbo.Begin(sizeof(MeshInstance));
+	batch.InstancesCapacity = batch.Vbo.GetAvailable() / sizeof(MeshInstance);
+}
+
+static void BeginParticles()
+{
+	auto &data = s_ParticleData;
+	data.InstanceDataPtr = (ParticleInstance *)data.InstanceVbo.Begin(sizeof(ParticleInstance));
+	data.InstancesCapacity = data.InstanceVbo.GetAvailable() / sizeof(ParticleInstance);
+}
+
+// Starts a draw at the end of the data written so far with the shader of 'mesh'.
+static void OpenDraw(bool translucent, uint32_t shader, uint32_t mesh)
+{
+	RunDraw draw{ translucent, shader, mesh, 0, 0, 0 };
+	if (shader == BatchShader)
+	{
+		s_RendererData.DrawVertex = s_RendererData.VerticesCount;
+		draw.First = s_RendererData.IndicesCount;
+		draw.BaseVertex = s_RendererData.VerticesCount;
+	}
+	else
+	{
+		draw.First = s_InstanceData.Batches[mesh].InstancesCount;
+	}
+
+	s_SceneData.Draws.push_back(draw);
+	s_SceneData.DrawOpen = true;
+}
+
+static void CloseDraw()
+{
+	RunDraw &draw = s_SceneData.Draws.back();
+	draw.Count = (draw.Shader == BatchShader ? s_RendererData.IndicesCount
+		: s_InstanceData.Batches[draw.Mesh].InstancesCount) - draw.First;
+
+	if (draw.Count == 0)
+	{
+		s_SceneData.Draws.pop_back();
+	}
+	s_SceneData.DrawOpen = false;
+}
+
+static GLuint CreateProgram(const char *vertexPath, const char *fragmentPath)
+{
+	auto vertexSrcRawOpt = ReadFile(vertexPath);
+	auto fragmentSrcRawOpt = ReadFile(fragmentPath);
+	ASSERT(vertexSrcRawOpt, "Could not load vertex shader source!");
+	ASSERT(fragmentSrcRawOpt, "Could not load fragment shader source!");
+
+	auto vertexSrcRaw = vertexSrcRawOpt.value();
+	auto fragmentSrcRaw = fragmentSrcRawOpt.value();
+	auto vertexSrcStr = std::string(vertexSrcRaw.begin(), vertexSrcRaw.end());
+	auto fragmentSrcStr = std::string(fragmentSrcRaw.begin(), fragmentSrcRaw.end());
+
+	const char *vertexSrc = vertexSrcStr.c_str();
+	const char *fragmentSrc = fragmentSrcStr.c_str();
+
+	int success;
+	char infoLog[1024];
+
+	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vertexShader, 1, &vertexSrc, NULL);
+	glCompileShader(vertexShader);
+	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		glGetShaderInfoLog(vertexShader, 1024, NULL, infoLog);
+		LOG("Vertex shader failed to compile!\n%s", infoLog);
+	}
+
+	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fragmentShader, 1, &fragmentSrc, NULL);
+	glCompileShader(fragmentShader);
+	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		glGetShaderInfoLog(fragmentShader, 1024, NULL, infoLog);
+		LOG("Fragment shader failed to compile!\n%s", infoLog);
+	}
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+
+	glDetachShader(program, vertexShader);
+	glDetachShader(program, fragmentShader);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	return program;
+}
+
+void Renderer::InitRenderer()
+{
+	s_RendererData.Program = CreateProgram("basic.vertex", "basic.fragment");
+
+	s_RendererData.Vbo.Init(sizeof(Vertex) * k_MaxVertices);
+	s_RendererData.Ibo.Init(sizeof(GLushort) * k_MaxIndices);
+
+	glGenVertexArrays(1, &s_RendererData.Vao);
+	glBindVertexArray(s_RendererData.Vao);
+	SetBatchAttributes();
+	glBindVertexArray(0);
+
+	InitInstanceRenderer();
+	InitParticleRenderer();
+}
+
+// Cubes and quads are instanced from a static unit mesh, so each one only uploads its transform
+// and colour.
+void Renderer::InitInstanceRenderer()
+{
+	s_InstanceData.Program = CreateProgram("instance.vertex", "basic.fragment");
+
+	std::vector<MeshVertex> vertices;
+	std::vector<GLushort> indices;
+
+	auto &cubes = s_InstanceData.Batches[CubeMesh];
+	cubes.First = indices.size();
+	AppendMesh(vertices, indices, k_UnitCube, k_CubeFaces);
+	cubes.Count = static_cast<GLsizei>(indices.size() - cubes.First);
+
+	auto &quads = s_InstanceData.Batches[QuadMesh];
+	quads.First = indices.size();
+	AppendMesh(vertices, indices, k_UnitQuad, k_QuadFaces);
+	quads.Count = static_cast<GLsizei>(indices.size() - quads.First);
+
+	glGenBuffers(1, &s_InstanceData.MeshVbo);
+	glBindBuffer(GL_ARRAY_BUFFER, s_InstanceData.MeshVbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(MeshVertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &s_InstanceData.MeshIbo);
+	glBindBuffer(GL_ARRAY_BUFFER, s_InstanceData.MeshIbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLushort) * indices.size(), indices.data(), GL_STATIC_DRAW);
+
+	for (auto &batch : s_InstanceData.Batches)
+	{
+		batch.Vbo.Init(sizeof(MeshInstance) * k_MaxInstances);
+		batch.Vao = CreateMeshVao();
+	}
+
+	// The static batch keeps its instances in a buffer of its own which is only written on rebuild.
+	glGenBuffers(1, &s_StaticData.Vbo);
+	s_StaticData.Vao = CreateMeshVao();
+
+	glBindVertexArray(s_StaticData.Vao);
+	SetInstanceAttributes(s_StaticData.Vbo, 0);
+	glBindVertexArray(0);
+}
+
+GLuint Renderer::CreateMeshVao()
+{
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_InstanceData.MeshIbo);
+	glBindBuffer(GL_ARRAY_BUFFER, s_InstanceData.MeshVbo);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (GLvoid *)offsetof(MeshVertex, Position));
+
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (GLvoid *)offsetof(MeshVertex, Normal));
+
+	for (GLuint location = 2; location <= 6; ++location)
+	{
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	return vao;
+}
+
+
+// Particles are instanced unit quads. Each instance carries its birth time, lifetime and colours, so
+// the vertex shader animates colour and size from 'u_Time' without any per-tick CPU work.
+void Renderer::InitParticleRenderer()
+{
+	static const glm::vec2 k_QuadCorners[] = {
+		{ -1.0f, -1.0f }, { 1.0f, -1.0f }, { -1.0f, 1.0f }, { 1.0f, 1.0f }
+	};
+
+	s_ParticleData.Program = CreateProgram("particle.vertex", "particle.fragment");
+
+	s_ParticleData.InstanceVbo.Init(sizeof(ParticleInstance) * k_MaxParticles);
+
+	glGenVertexArrays(1, &s_ParticleData.Vao);
+	glGenBuffers(1, &s_ParticleData.QuadVbo);
+
+	glBindVertexArray(s_ParticleData.Vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, s_ParticleData.QuadVbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(k_QuadCorners), k_QuadCorners, GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (GLvoid *)0);
+
+	for (GLuint location = 1; location <= 4; ++location)
+	{
+		glEnableVertexAttribArray(location);
+		glVertexAttribDivisor(location, 1);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void Renderer::CleanupRenderer()
+{
+	glDeleteProgram(s_RendererData.Program);
+	s_RendererData.Vbo.Terminate();
+	s_RendererData.Ibo.Terminate();
+	glDeleteVertexArrays(1, &s_RendererData.Vao);
+
+	glDeleteProgram(s_InstanceData.Program);
+	glDeleteBuffers(1, &s_InstanceData.MeshVbo);
+	glDeleteBuffers(1, &s_InstanceData.MeshIbo);
+	for (auto &batch : s_InstanceData.Batches)
+	{
+		batch.Vbo.Terminate();
+		glDeleteVertexArrays(1, &batch.Vao);
+	}
+
+	glDeleteBuffers(1, &s_StaticData.Vbo);
+	glDeleteVertexArrays(1, &s_StaticData.Vao);
+
+	glDeleteProgram(s_ParticleData.Program);
+	glDeleteBuffers(1, &s_ParticleData.QuadVbo);
+	s_ParticleData.InstanceVbo.Terminate();
+	glDeleteVertexArrays(1, &s_ParticleData.Vao);
+}
+
+void Renderer::FlushDraws()
+{
+	bool reopen = s_SceneData.DrawOpen;
+	RunDraw open{};
+	if (reopen)
+	{
+		open = s_SceneData.Draws.back();
+		CloseDraw();
+	}
+
+	// Writing is done, so the data can be unmapped and every draw issued from its sub-range.
+	size_t vertexOffset = s_RendererData.Vbo.End(sizeof(Vertex) * s_RendererData.VerticesCount);
+	size_t indexOffset = s_RendererData.Ibo.End(sizeof(GLushort) * s_RendererData.IndicesCount);
+
+	std::array<size_t, MeshCount> instanceOffsets;
+	for (size_t mesh = 0; mesh < MeshCount; ++mesh)
+	{
+		auto &batch = s_InstanceData.Batches[mesh];
+		instanceOffsets[mesh] = batch.Vbo.End(sizeof(MeshInstance) * batch.InstancesCount);
+	}
+
+	for (const RunDraw &draw : s_SceneData.Draws)
+	{
+		SetTranslucent(draw.Translucent);
+		if (draw.Shader == BatchShader)
+		{
+			BindState(s_RendererData.Program, s_RendererData.Vao);
+			glDrawElementsBaseVertex(GL_TRIANGLES, draw.Count, GL_UNSIGNED_SHORT,
+				(GLvoid *)(indexOffset + sizeof(GLushort) * draw.First),
+				static_cast<GLint>(vertexOffset / sizeof(Vertex)) + draw.BaseVertex);
+		}
+		else
+		{
+			auto &batch = s_InstanceData.Batches[draw.Mesh];
+			BindState(s_InstanceData.Program, batch.Vao);
+			SetInstanceAttributes(batch.Vbo.GetBuffer(), instanceOffsets[draw.Mesh] + sizeof(MeshInstance) * draw.First);
+
+			glDrawElementsInstanced(GL_TRIANGLES, batch.Count, GL_UNSIGNED_SHORT,
+				(GLvoid *)(batch.First * sizeof(GLushort)), draw.Count);
+		}
+	}
+	s_SceneData.Draws.clear();
+
+	s_RendererData.VerticesCount = 0;
+	s_RendererData.IndicesCount = 0;
+	BeginVertices();
+	for (auto &batch : s_InstanceData.Batches)
+	{
+		batch.InstancesCount = 0;
+		BeginInstances(batch);
+	}
+
+	if (reopen)
+	{
+		OpenDraw(open.Translucent, open.Shader, open.Mesh);
+	}
+}
+
+void Renderer::ReserveVertices(size_t vertices, size_t indices)
+{
+	auto &data = s_RendererData;
+	if (data.VerticesCount + vertices > data.VerticesCapacity || data.IndicesCount + indices > data.IndicesCapacity)
+	{
+		FlushDraws();
+	}
+	else if (data.VerticesCount - data.DrawVertex + vertices > k_MaxVertices)
+	{
+		// Out of 16 bit indices, the run carries on in a draw of its own.
+		RunDraw open = s_SceneData.Draws.back();
+		CloseDraw();
+		OpenDraw(open.Translucent, open.Shader, open.Mesh);
+	}
+}
+
+void Renderer::DrawStaticBatch()
+{
+	if (s_StaticData.InstancesCount == 0)
+	{
+		return;
+	}
+
+	const auto &cubes = s_InstanceData.Batches[CubeMesh];
+
+	SetTranslucent(false);
+	BindState(s_InstanceData.Program, s_StaticData.Vao);
+	glDrawElementsInstanced(GL_TRIANGLES, cubes.Count, GL_UNSIGNED_SHORT,
+		(GLvoid *)(cubes.First * sizeof(GLushort)), s_StaticData.InstancesCount);
+}
+
+void Renderer::FlushParticles()
+{
+	if (s_ParticleData.InstancesCount == 0)
+	{
+		return;
+	}
+
+	size_t offset = s_ParticleData.InstanceVbo.End(sizeof(ParticleInstance) * s_ParticleData.InstancesCount);
+
+	SetTranslucent(true);
+	BindState(s_ParticleData.Program, s_ParticleData.Vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, s_ParticleData.InstanceVbo.GetBuffer());
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (GLvoid *)(offset + offsetof(ParticleInstance, Position)));
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (GLvoid *)(offset + offsetof(ParticleInstance, InitialColour)));
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (GLvoid *)(offset + offsetof(ParticleInstance, FinalColour)));
+	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (GLvoid *)(offset + offsetof(ParticleInstance, Lifetime)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, s_ParticleData.InstancesCount);
+
+	s_ParticleData.InstancesCount = 0;
+
+	BeginParticles();
+}
+
+// Particles are already instanced and blended in any order, so they are drawn last rather than
+// sorted one by one.
+void Renderer::FlushScene()
+{
+	DrawStaticBatch();
+	ExecuteCommands();
+	FlushParticles();
+}
+
+void Renderer::ExecuteCommands()
+{
+	MergeSubmitContexts();
+
+	SubmitContext &scene = s_SceneData.Contexts[0];
+	scene.Queue.Sort();
+
+	const RenderCommand *command = scene.Queue.begin();
+	const RenderCommand *end = scene.Queue.end();
+
+	while (command != end)
+	{
+		// Run of consecutive commands which draw with the same state.
+		uint64_t key = command->Key;
+		bool translucent = RenderQueue::IsTranslucent(key);
+		uint32_t state = RenderQueue::GetState(key);
+
+		const RenderCommand *runEnd = command + 1;
+		while (runEnd != end && RenderQueue::IsTranslucent(runEnd->Key) == translucent
+			&& RenderQueue::GetState(runEnd->Key) == state)
+		{
+			++runEnd;
+		}
+
+		uint32_t shader = RenderQueue::GetShader(key);
+		uint32_t mesh = shader == BatchShader ? 0 : RenderQueue::GetMaterial(key);
+
+		OpenDraw(translucent, shader, mesh);
+		if (shader == BatchShader)
+		{
+			DrawBatchRun(command, runEnd);
+		}
+		else
+		{
+			DrawInstanceRun(mesh, command, runEnd);
+		}
+		CloseDraw();
+
+		command = runEnd;
+	}
+
+	FlushDraws();
+
+	scene.Queue.Clear();
+	scene.Positions.clear();
+	scene.Primitives.clear();
+	scene.Instances.clear();
+}
+
+void Renderer::DrawBatchRun(const RenderCommand *begin, const RenderCommand *end)
+{
+	const SubmitContext &scene = s_SceneData.Contexts[0];
+
+	for (const RenderCommand *command = begin; command != end; ++command)
+	{
+		const BatchPrimitive &primitive = scene.Primitives[command->Payload];
+		const glm::vec3 *v = scene.Positions.data() + primitive.First;
+
+		if (primitive.Count == 3)
+		{
+			ReserveVertices(3, 3);
+			AppendTriangle(v[0], v[1], v[2], primitive.Colour);
+		}
+		else if (primitive.Count == 4)
+		{
+			ReserveVertices(4, 6);
+			AppendFace(v[0], v[1], v[2], v[3], primitive.Colour);
+		}
+		else
+		{
+			ReserveVertices(k_MaxPrimitiveVertices, k_MaxPrimitiveIndices);
+			for (const auto &face : k_CubeFaces)
+			{
+				AppendFace(v[face[0]], v[face[1]], v[face[2]], v[face[3]], primitive.Colour);
+			}
+		}
+	}
+}
+
+void Renderer::DrawInstanceRun(size_t mesh, const RenderCommand *begin, const RenderCommand *end)
+{
+	const SubmitContext &scene = s_SceneData.Contexts[0];
+	auto &batch = s_InstanceData.Batches[mesh];
+
+	for (const RenderCommand *command = begin; command != end; ++command)
+	{
+		if (static_cast<size_t>(batch.InstancesCount) + 1 > batch.InstancesCapacity)
+		{
+			FlushDraws();
+		}
+
+		*batch.InstanceDataPtr++ = scene.Instances[command->Payload];
+		batch.InstancesCount++;
+	}
+}
+
+void Renderer::Init()
+{
+	InitRenderer();
+
+	s_SceneData.Contexts.resize(JobSystem::GetThreadCount());
+
+	glClearColor(0.2f, 0.5f, 0.7f, 1.0f);
+
+	// Blending is only enabled for translucent draws, see 'SetTranslucent'.
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glEnable(GL_DEPTH_TEST);
+}
+
+void Renderer::Terminate()
+{
+	CleanupRenderer();
+}
+
+void Renderer::SetViewportSize(int width, int height)
+{
+	glViewport(0, 0, width, height);
+}
+
+void Renderer::BeginScene(const RenderContext &context)
+{
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glm::mat4 viewMatrix = context.camera->GetViewMatrix();
+	glm::mat4 profMatrix = context.camera->GetProjMatrix();
+
+	s_SceneData.View = viewMatrix;
+	for (auto &context : s_SceneData.Contexts)
+	{
+		context.Layer = 0;
+	}
+
+	for (GLuint program : { s_RendererData.Program, s_InstanceData.Program, s_ParticleData.Program })
+	{
+		glUseProgram(program);
+
+		GLint loc;
+		loc = glGetUniformLocation(program, "u_View");
+		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+		loc = glGetUniformLocation(program, "u_Proj");
+		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(profMatrix));
+	}
+
+	glUseProgram(s_ParticleData.Program);
+
+	GLint loc = glGetUniformLocation(s_ParticleData.Program, "u_Time");
+	glUniform1f(loc, context.time);
+	glUseProgram(0);
+
+	// Every stream buffer writes the whole scene into one region, fenced once by 'EndScene'.
+	s_RendererData.Vbo.BeginFrame();
+	s_RendererData.Ibo.BeginFrame();
+	BindState(s_RendererData.Program, s_RendererData.Vao);
+	SetBatchAttributes();
+	BeginVertices();
+	for (auto &batch : s_InstanceData.Batches)
+	{
+		batch.Vbo.BeginFrame();
+		BeginInstances(batch);
+	}
+	s_ParticleData.InstanceVbo.BeginFrame();
+	BeginParticles();
+}
+
+void Renderer::EndScene()
+{
+	FlushScene();
+
+	s_RendererData.Vbo.End(0);
+	s_RendererData.Ibo.End(0);
+	s_RendererData.Vbo.EndFrame();
+	s_RendererData.Ibo.EndFrame();
+	for (auto &batch : s_InstanceData.Batches)
+	{
+		batch.Vbo.End(0);
+		batch.Vbo.EndFrame();
+	}
+	s_ParticleData.InstanceVbo.End(0);
+	s_ParticleData.InstanceVbo.EndFrame();
+
+	SetTranslucent(false);
+	BindState(0, 0);
+}
+
+void Renderer::SetLayer(uint32_t layer)
+{
+	ASSERT(layer < RenderQueue::k_MaxLayers, "Render layer out of range !");
+	GetSubmitContext().Layer = layer;
+}
+
+void Renderer::SubmitPrimitive(const glm::vec3 *vertices, size_t count, glm::vec4 colour)
+{
+	glm::vec3 centre{ 0.0f };
+	for (size_t i = 0; i < count; ++i)
+	{
+		centre += vertices[i];
+	}
+	centre *= 1.0f / count;
+
+	SubmitContext &context = GetSubmitContext();
+
+	uint32_t index = static_cast<uint32_t>(context.Primitives.size());
+	context.Primitives.push_back({ static_cast<uint32_t>(context.Positions.size()), static_cast<uint32_t>(count), colour });
+	context.Positions.insert(context.Positions.end(), vertices, vertices + count);
+
+	context.Queue.Push(RenderQueue::MakeKey(context.Layer, colour.a < 1.0f, BatchShader, 0, ViewDepth(centre)), index);
+}
+
+// Queues the 'count' primitives of 'corners' vertices each written to the context's positions
+// from 'first', 'centres' being the centre of each.
+static void QueuePrimitives(SubmitContext &context, size_t first, size_t corners, const glm::vec3 *centres,
+	const glm::vec4 *colours, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint32_t index = static_cast<uint32_t>(context.Primitives.size());
+		context.Primitives.push_back({ static_cast<uint32_t>(first + i * corners), static_cast<uint32_t>(corners), colours[i] });
+
+		context.Queue.Push(RenderQueue::MakeKey(context.Layer, colours[i].a < 1.0f, BatchShader, 0, ViewDepth(centres[i])), index);
+	}
+}
+
+void Renderer::SubmitQuads(const glm::vec3 *positions, const glm::vec3 *scales, const glm::vec3 *rotations,
+	const glm::vec4 *colours, size_t count)
+{
+	SubmitContext &context = GetSubmitContext();
+
+	size_t first = context.Positions.size();
+	context.Positions.resize(first + count * 4);
+	MakeQuadVertices(positions, scales, rotations, count, context.Positions.data() + first);
+
+	QueuePrimitives(context, first, 4, positions, colours, count);
+}
+
+void Renderer::SubmitCubes(const glm::vec3 *positions, const glm::vec3 *scales, const glm::vec3 *rotations,
+	const glm::vec4 *colours, size_t count)
+{
+	SubmitContext &context = GetSubmitContext();
+
+	size_t first = context.Positions.size();
+	context.Positions.resize(first + count * 8);
+	MakeCubeVertices(positions, scales, rotations, count, context.Positions.data() + first);
+
+	QueuePrimitives(context, first, 8, positions, colours, count);
+}
+
+void Renderer::SubmitInstance(size_t mesh, const glm::mat4 &transform, glm::vec4 colour)
+{
+	SubmitContext &context = GetSubmitContext();
+
+	uint32_t index = static_cast<uint32_t>(context.Instances.size());
+	context.Instances.push_back({ transform, colour });
+
+	glm::vec3 position{ transform[3] };
+	context.Queue.Push(RenderQueue::MakeKey(context.Layer, colour.a < 1.0f, InstanceShader,
+		static_cast<uint32_t>(mesh), ViewDepth(position)), index);
+}
+
+void Renderer::BeginStaticBatch()
+{
+	ASSERT(JobSystem::GetThreadIndex() == 0, "The static batch can only be built on the main thread !");
+	s_StaticData.Instances.clear();
+}
+
+void Renderer::SubmitStaticCube(const glm::mat4 &transform, glm::vec4 colour)
+{
+	s_StaticData.Instances.push_back({ transform, colour });
+}
+
+void Renderer::EndStaticBatch()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, s_StaticData.Vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(MeshInstance) * s_StaticData.Instances.size(),
+		s_StaticData.Instances.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	s_StaticData.InstancesCount = static_cast<GLsizei>(s_StaticData.Instances.size());
+	s_StaticData.Instances.clear();
+}
+
+void Renderer::SubmitParticle(const ParticleInstance &particle)
+{
+	ASSERT(JobSystem::GetThreadIndex() == 0, "Particles can only be submitted on the main thread !");
+	if (static_cast<size_t>(s_ParticleData.InstancesCount) + 1 > s_ParticleData.InstancesCapacity)
+	{
+		FlushParticles();
+	}
+
+	*s_ParticleData.InstanceDataPtr++ = particle;
+	s_ParticleData.InstancesCount++;
+}
+
+void Renderer::SubmitTriangle(const std::array<glm::vec3, 3> &vertices, glm::vec4 colour)
+{
+	SubmitPrimitive(vertices.data(), vertices.size(), colour);
+}
+
+void Renderer::SubmitQuad(const std::array<glm::vec3, 4> &vertices, glm::vec4 colour)
+{
+	SubmitPrimitive(vertices.data(), vertices.size(), colour);
+}
+
+void Renderer::SubmitQuad(const glm::mat4 &transform, glm::vec4 colour)
+{
+	SubmitInstance(QuadMesh, transform, colour);
+}
+
+void Renderer::SubmitCube(const std::array<glm::vec3, 8> &vertices, glm::vec4 colour)
+{
+	SubmitPrimitive(vertices.data(), vertices.size(), colour);
+}
+
+void Renderer::SubmitCube(const glm::mat4 &transform, glm::vec4 colour)
+{
+	SubmitInstance(CubeMesh, transform, colour);
+}
@@ -1,35 +1,90 @@
-#pragma once
-
-#include "Camera.hpp"
-
-#include <array>
-
-struct RenderContext
-{
-	const Camera *camera;
-};
-
-class Renderer
-{
-private:
-	static void InitRenderer();
-	static void CleanupRenderer();
-	static void FlushVertices();
-	static void FlushScene();
-
-	static void MapBuffer();
-	static void UnmapBuffer();
-
-public:
-	static void Init();
-	static void Terminate();
-
-	static void SetViewportSize(int width, int height);
-
-	static void BeginScene(const RenderContext &context);
-	static void EndScene();
-
-	static void SubmitTriangle(const std::array<glm::vec3, 3> &vertices, glm::vec4 colour);
-	static void SubmitQuad(const std::array<glm::vec3, 4> &vertices, glm::vec4 colour);
-	static void SubmitCube(const std::array<glm::vec3, 8> &vertices, glm::vec4 colour);
-};
+#pragma once
+
+#include "Camera.hpp"
+#include "RenderQueue.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct RenderContext
+{
+	const Camera *camera;
+	// Clock which particle birth times are measured against.
+	float time = 0.0f;
+};
+
+struct ParticleInstance
+{
+	glm::vec3 Position;
+	float BirthTime;
+	glm::vec4 InitialColour;
+	glm::vec4 FinalColour;
+	float Lifetime;
+	float InitialSize;
+	float FinalSize;
+};
+
+class Renderer
+{
+private:
+	static void InitRenderer();
+	static void InitInstanceRenderer();
+	static void InitParticleRenderer();
+	static unsigned int CreateMeshVao();
+	static void CleanupRenderer();
+	// Issues the draws recorded so far and maps fresh space for the rest of the scene.
+	static void FlushDraws();
+	// Makes room in the open batch draw for another primitive of this size.
+	static void ReserveVertices(size_t vertices, size_t indices);
+	static void DrawStaticBatch();
+	static void FlushParticles();
+	static void FlushScene();
+
+	// Sorts the scene's commands and draws each run of commands sharing state with one call, from
+	// a sub-range of the stream buffers the whole scene is written into.
+	static void ExecuteCommands();
+	static void DrawBatchRun(const RenderCommand *begin, const RenderCommand *end);
+	static void DrawInstanceRun(size_t mesh, const RenderCommand *begin, const RenderCommand *end);
+
+	static void SubmitPrimitive(const glm::vec3 *vertices, size_t count, glm::vec4 colour);
+	static void SubmitInstance(size_t mesh, const glm::mat4 &transform, glm::vec4 colour);
+
+public:
+	static void Init();
+	static void Terminate();
+
+	static void SetViewportSize(int width, int height);
+
+	// Submissions are queued and only drawn by 'EndScene', sorted by layer first. Anything with
+	// alpha below 1 is blended back to front after the opaque geometry of its layer.
+	// Triangles, quads and cubes may be submitted from any job system thread in between, each
+	// thread records into its own context. Particles and the static batch are main thread only.
+	static void BeginScene(const RenderContext &context);
+	static void EndScene();
+
+	// Layer of the following submissions, in [0, 16), reset to 0 by 'BeginScene'.
+	static void SetLayer(uint32_t layer);
+
+	static void SubmitTriangle(const std::array<glm::vec3, 3> &vertices, glm::vec4 colour);
+	static void SubmitQuad(const std::array<glm::vec3, 4> &vertices, glm::vec4 colour);
+	static void SubmitCube(const std::array<glm::vec3, 8> &vertices, glm::vec4 colour);
+
+	// Batched, the corners of all 'count' quads or cubes are computed at once with the SIMD
+	// kernels of 'MakeQuadVertices' and 'MakeCubeVertices', from parallel arrays.
+	static void SubmitQuads(const glm::vec3 *positions, const glm::vec3 *scales, const glm::vec3 *rotations,
+		const glm::vec4 *colours, size_t count);
+	static void SubmitCubes(const glm::vec3 *positions, const glm::vec3 *scales, const glm::vec3 *rotations,
+		const glm::vec4 *colours, size_t count);
+
+	// Instanced, 'transform' maps the unit quad or cube, i.e. corners at -1 and 1, to world space.
+	static void SubmitQuad(const glm::mat4 &transform, glm::vec4 colour);
+	static void SubmitCube(const glm::mat4 &transform, glm::vec4 colour);
+	static void SubmitParticle(const ParticleInstance &particle);
+
+	// Retained cubes, drawn every scene with a single call until the batch is rebuilt. Rebuilding
+	// replaces the whole batch, so only do it when its contents change.
+	static void BeginStaticBatch();
+	static void SubmitStaticCube(const glm::mat4 &transform, glm::vec4 colour);
+	static void EndStaticBatch();
+};
@@ -0,0 +1,154 @@
+#include "StreamBuffer.hpp"
+
+#include "util/Log.h"
+
+static constexpr GLuint64 k_FenceTimeout = 1000 * 1000 * 1000;
+
+StreamBuffer::StreamBuffer()
+	: m_Buffer(0), m_RegionSize(0), m_Region(0), m_Cursor(0), m_Grow(false), m_Mapped(false)
+	, m_Persistent(false), m_PersistentPtr(nullptr)
+{
+	m_Fences.fill(nullptr);
+}
+
+void StreamBuffer::Init(size_t regionSize)
+{
+	m_RegionSize = regionSize;
+	m_Region = 0;
+	m_Cursor = 0;
+	m_Grow = false;
+	m_Persistent = GLAD_GL_VERSION_4_4 != 0;
+
+	GLsizeiptr size = static_cast<GLsizeiptr>(m_RegionSize * k_RegionCount);
+
+	glGenBuffers(1, &m_Buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+
+	if (m_Persistent)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, size, (GLvoid *)0, flags);
+		m_PersistentPtr = static_cast<uint8_t *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+		ASSERT(m_PersistentPtr, "Failed to persistently map stream buffer !");
+	}
+	else
+	{
+		glBufferData(GL_ARRAY_BUFFER, size, (GLvoid *)0, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::Terminate()
+{
+	for (GLsync &fence : m_Fences)
+	{
+		if (fence)
+		{
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	if (m_Persistent || m_Mapped)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_PersistentPtr = nullptr;
+		m_Mapped = false;
+	}
+
+	glDeleteBuffers(1, &m_Buffer);
+	m_Buffer = 0;
+}
+
+void StreamBuffer::BeginFrame()
+{
+	ASSERT(!m_Mapped, "Stream buffer frames must begin unmapped !");
+
+	// Pending draws keep the old buffer's storage alive, so it can be replaced right away.
+	if (m_Grow)
+	{
+		size_t regionSize = m_RegionSize * 2;
+		LOG("Growing stream buffer regions to '%zu' bytes !", regionSize);
+		Terminate();
+		Init(regionSize);
+	}
+
+	Wait(m_Region);
+	m_Cursor = 0;
+}
+
+void StreamBuffer::EndFrame()
+{
+	ASSERT(!m_Mapped, "Stream buffer frames must end unmapped !");
+
+	m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_Region = (m_Region + 1) % k_RegionCount;
+}
+
+void *StreamBuffer::Begin(size_t minSize)
+{
+	ASSERT(minSize <= m_RegionSize, "Stream buffer regions are smaller than '%zu' bytes !", minSize);
+
+	// Out of space, this frame carries on in the next region and later frames get bigger ones.
+	if (GetAvailable() < minSize)
+	{
+		m_Grow = true;
+		EndFrame();
+		Wait(m_Region);
+		m_Cursor = 0;
+	}
+
+	size_t offset = m_Region * m_RegionSize + m_Cursor;
+	if (m_Persistent)
+	{
+		return m_PersistentPtr + offset;
+	}
+
+	// The region's fence already guarantees the GPU is done with it, so the driver must not sync.
+	glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+	void *data = glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(GetAvailable()),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_Mapped = true;
+	return data;
+}
+
+size_t StreamBuffer::End(size_t size)
+{
+	ASSERT(size <= GetAvailable(), "Wrote '%zu' bytes past the end of a stream buffer region !", size - GetAvailable());
+
+	if (m_Mapped)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_Mapped = false;
+	}
+
+	size_t offset = m_Region * m_RegionSize + m_Cursor;
+	m_Cursor += size;
+	return offset;
+}
+
+void StreamBuffer::Wait(size_t region)
+{
+	GLsync &fence = m_Fences[region];
+	if (!fence)
+	{
+		return;
+	}
+
+	GLenum result;
+	do
+	{
+		result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, k_FenceTimeout);
+	}
+	while (result == GL_TIMEOUT_EXPIRED);
+	ASSERT(result != GL_WAIT_FAILED, "Failed waiting on stream buffer fence !");
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//-------------------------------------------------------------------------------------------------
+//	StreamBuffer
+//
+//	Ring of per frame regions within a single buffer object. Everything written during a frame is
+//	sub-allocated from the frame's region at a write cursor, so any number of draws share it, and
+//	the region is fenced once when the frame ends. A region is only waited on when the ring comes
+//	back round to it 'k_RegionCount' frames later, so the CPU never waits on the frame before.
+//	A frame writing more than a region holds spills into the next one and the buffer is grown at
+//	the start of the following frame, which renames it. Each buffer holds a single element type
+//	and regions are sized in whole elements, so offsets stay multiples of the element size.
+//	Regions are mapped persistently when the context supports GL 4.4 buffer storage, otherwise
+//	each write is mapped unsynchronized.
+//-------------------------------------------------------------------------------------------------
+class StreamBuffer
+{
+public:
+	static constexpr size_t k_RegionCount = 3;
+
+	StreamBuffer();
+
+	StreamBuffer(const StreamBuffer &other) = delete;
+	StreamBuffer& operator=(const StreamBuffer &other) = delete;
+
+	void Init(size_t regionSize);
+	void Terminate();
+
+	// Starts writing the frame's region, waiting for the GPU only if it still reads from it.
+	void BeginFrame();
+	// Fences the draws issued from the frame's region and moves on to the next one.
+	void EndFrame();
+
+	// Returns the space at the write cursor, 'GetAvailable' bytes and at least 'minSize'.
+	void *Begin(size_t minSize);
+	// Ends writing and moves the cursor past the 'size' bytes written, returning their byte
+	// offset within the buffer to draw from.
+	size_t End(size_t size);
+
+	size_t GetAvailable() const { return m_RegionSize - m_Cursor; }
+	GLuint GetBuffer() const { return m_Buffer; }
+	size_t GetRegionSize() const { return m_RegionSize; }
+
+private:
+	void Wait(size_t region);
+
+private:
+	GLuint m_Buffer;
+	size_t m_RegionSize;
+	size_t m_Region;
+	size_t m_Cursor;
+	// Set when a frame spilled out of its region.
+	bool m_Grow;
+	bool m_Mapped;
+
+	bool m_Persistent;
+	uint8_t *m_PersistentPtr;
+
+	std::array<GLsync, k_RegionCount> m_Fences;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+
+//-------------------------------------------------------------------------------------------------
+//	Aabb
+//
+//	Axis aligned bounding box given by its minimum and maximum corners.
+//-------------------------------------------------------------------------------------------------
+struct Aabb
+{
+	glm::vec3 Min;
+	glm::vec3 Max;
+
+	static Aabb FromCentre(glm::vec3 centre, glm::vec3 extents)
+	{
+		return { centre - extents, centre + extents };
+	}
+
+	static Aabb Union(const Aabb &a, const Aabb &b)
+	{
+		return { glm::min(a.Min, b.Min), glm::max(a.Max, b.Max) };
+	}
+
+	Aabb Expanded(float margin) const
+	{
+		return { Min - glm::vec3(margin), Max + glm::vec3(margin) };
+	}
+
+	bool Contains(const Aabb &other) const
+	{
+		return Min.x <= other.Min.x && Min.y <= other.Min.y && Min.z <= other.Min.z
+			&& other.Max.x <= Max.x && other.Max.y <= Max.y && other.Max.z <= Max.z;
+	}
+
+	bool Overlaps(const Aabb &other) const
+	{
+		return Min.x <= other.Max.x && other.Min.x <= Max.x
+			&& Min.y <= other.Max.y && other.Min.y <= Max.y
+			&& Min.z <= other.Max.z && other.Min.z <= Max.z;
+	}
+
+	bool Overlaps(glm::vec3 centre, float radius) const
+	{
+		glm::vec3 closest = glm::clamp(centre, Min, Max);
+		glm::vec3 offset = centre - closest;
+		return glm::dot(offset, offset) <= radius * radius;
+	}
+
+	// Slab test against the ray 'origin + t * direction' for t in [0, maxDistance], where
+	// 'invDirection' is the reciprocal of the direction. On a hit 'distance' is the entry t.
+	bool Raycast(glm::vec3 origin, glm::vec3 invDirection, float maxDistance, float &distance) const
+	{
+		float enter = 0.0f;
+		float exit = maxDistance;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float t1 = (Min[axis] - origin[axis]) * invDirection[axis];
+			float t2 = (Max[axis] - origin[axis]) * invDirection[axis];
+			enter = std::max(enter, std::min(t1, t2));
+			exit = std::min(exit, std::max(t1, t2));
+		}
+		distance = enter;
+		return enter <= exit;
+	}
+
+	// Half the surface area, the insertion cost metric of the AABB tree.
+	float HalfArea() const
+	{
+		glm::vec3 size = Max - Min;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+};
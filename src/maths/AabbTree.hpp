@@ -0,0 +1,419 @@
+#pragma once
+
+#include "maths/Aabb.hpp"
+#include "maths/Frustum.hpp"
+#include "util/Log.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+//	AabbTree
+//
+//	Dynamic bounding volume hierarchy. Each leaf stores a 'fat' box, the inserted box grown by
+//	'margin', so objects moving a little inside it need no tree update at all. Leaves are inserted
+//	next to the sibling minimising the added surface area and the tree is kept height balanced
+//	with rotations, so queries visit O(log n) nodes. Proxies are node indices and stay valid until
+//	removed.
+//-------------------------------------------------------------------------------------------------
+class AabbTree
+{
+	// Enough for a balanced tree of far more leaves than fit in memory, deeper ones spill to the heap.
+	static constexpr size_t k_StackSize = 256;
+
+public:
+	static constexpr int32_t k_Null = -1;
+
+	explicit AabbTree(float margin = 0.1f)
+		: m_Root(k_Null), m_FreeList(k_Null), m_LeafCount(0), m_Margin(margin)
+	{
+	}
+
+	int32_t Insert(const Aabb &aabb, uint32_t userData)
+	{
+		int32_t leaf = AllocateNode();
+		m_Nodes[leaf].Box = aabb.Expanded(m_Margin);
+		m_Nodes[leaf].UserData = userData;
+		m_Nodes[leaf].Height = 0;
+
+		InsertLeaf(leaf);
+		++m_LeafCount;
+		return leaf;
+	}
+
+	void Remove(int32_t proxy)
+	{
+		ASSERT(m_Nodes[proxy].IsLeaf(), "Only leaves can be removed !");
+
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+		--m_LeafCount;
+	}
+
+	// Returns true if the proxy had to be reinserted, false if 'aabb' still fits its fat box.
+	bool Move(int32_t proxy, const Aabb &aabb)
+	{
+		if (m_Nodes[proxy].Box.Contains(aabb))
+		{
+			return false;
+		}
+
+		RemoveLeaf(proxy);
+		m_Nodes[proxy].Box = aabb.Expanded(m_Margin);
+		InsertLeaf(proxy);
+		return true;
+	}
+
+	uint32_t GetUserData(int32_t proxy) const { return m_Nodes[proxy].UserData; }
+	const Aabb &GetFatAabb(int32_t proxy) const { return m_Nodes[proxy].Box; }
+
+	size_t Size() const { return m_LeafCount; }
+	int32_t GetHeight() const { return m_Root == k_Null ? 0 : m_Nodes[m_Root].Height; }
+
+	// Each query calls 'func(userData)' for every leaf whose fat box passes the test, so results
+	// are conservative and may need an exact test by the caller.
+	template<typename Func>
+	void Query(const Aabb &aabb, Func &&func) const
+	{
+		Traverse([&](const Aabb &box) { return box.Overlaps(aabb); }, func);
+	}
+
+	template<typename Func>
+	void Query(const Frustum &frustum, Func &&func) const
+	{
+		Traverse([&](const Aabb &box) { return frustum.Intersects(box); }, func);
+	}
+
+	template<typename Func>
+	void QuerySphere(glm::vec3 centre, float radius, Func &&func) const
+	{
+		Traverse([&](const Aabb &box) { return box.Overlaps(centre, radius); }, func);
+	}
+
+	// Calls 'func(userData, distance)' for every leaf the ray enters within 'maxDistance', where
+	// 'distance' is where it enters the fat box. Leaves are not visited in order of distance.
+	template<typename Func>
+	void Raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, Func &&func) const
+	{
+		glm::vec3 invDirection{ 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+		float distance = 0.0f;
+
+		Traverse(
+			[&](const Aabb &box) { return box.Raycast(origin, invDirection, maxDistance, distance); },
+			[&](uint32_t userData) { func(userData, distance); }
+		);
+	}
+
+private:
+	struct Node
+	{
+		Aabb Box;
+		uint32_t UserData;
+		// Next free node while on the free list.
+		int32_t Parent;
+		int32_t Child1, Child2;
+		// Leaves are 0, free nodes -1.
+		int32_t Height;
+
+		bool IsLeaf() const { return Child1 == k_Null; }
+	};
+
+	// Stack of node indices kept on the call stack until it outgrows 'N', then moved to the heap.
+	template<size_t N>
+	class GrowableStack
+	{
+	public:
+		GrowableStack()
+			: m_Data(m_Inline), m_Capacity(N), m_Count(0)
+		{
+		}
+
+		GrowableStack(const GrowableStack &other) = delete;
+		GrowableStack& operator=(const GrowableStack &other) = delete;
+
+		void Push(int32_t value)
+		{
+			if (m_Count == m_Capacity)
+			{
+				if (m_Heap.empty())
+				{
+					m_Heap.assign(m_Inline, m_Inline + m_Count);
+				}
+				m_Heap.resize(m_Capacity * 2);
+				m_Data = m_Heap.data();
+				m_Capacity = m_Heap.size();
+			}
+			m_Data[m_Count++] = value;
+		}
+
+		int32_t Pop() { return m_Data[--m_Count]; }
+		bool Empty() const { return m_Count == 0; }
+
+	private:
+		int32_t m_Inline[N];
+		std::vector<int32_t> m_Heap;
+		int32_t *m_Data;
+		size_t m_Capacity;
+		size_t m_Count;
+	};
+
+	template<typename Test, typename Func>
+	void Traverse(Test &&test, Func &&func) const
+	{
+		if (m_Root == k_Null)
+		{
+			return;
+		}
+
+		GrowableStack<k_StackSize> stack;
+		stack.Push(m_Root);
+
+		while (!stack.Empty())
+		{
+			const Node &node = m_Nodes[stack.Pop()];
+			if (!test(node.Box))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				func(node.UserData);
+			}
+			else
+			{
+				stack.Push(node.Child1);
+				stack.Push(node.Child2);
+			}
+		}
+	}
+
+	int32_t AllocateNode()
+	{
+		int32_t index;
+		if (m_FreeList != k_Null)
+		{
+			index = m_FreeList;
+			m_FreeList = m_Nodes[index].Parent;
+		}
+		else
+		{
+			index = static_cast<int32_t>(m_Nodes.size());
+			m_Nodes.emplace_back();
+		}
+
+		Node &node = m_Nodes[index];
+		node.UserData = 0;
+		node.Parent = k_Null;
+		node.Child1 = k_Null;
+		node.Child2 = k_Null;
+		node.Height = 0;
+		return index;
+	}
+
+	void FreeNode(int32_t index)
+	{
+		m_Nodes[index].Parent = m_FreeList;
+		m_Nodes[index].Height = -1;
+		m_FreeList = index;
+	}
+
+	void InsertLeaf(int32_t leaf)
+	{
+		if (m_Root == k_Null)
+		{
+			m_Root = leaf;
+			m_Nodes[leaf].Parent = k_Null;
+			return;
+		}
+
+		// Descend towards the cheapest sibling, the cost of a node being the area it would gain.
+		Aabb leafBox = m_Nodes[leaf].Box;
+		int32_t index = m_Root;
+		while (!m_Nodes[index].IsLeaf())
+		{
+			const Node &node = m_Nodes[index];
+
+			float area = node.Box.HalfArea();
+			float combinedArea = Aabb::Union(node.Box, leafBox).HalfArea();
+
+			// Cost of pairing the leaf with this node, and the minimum cost pushed down to children.
+			float cost = 2.0f * combinedArea;
+			float inheritance = 2.0f * (combinedArea - area);
+
+			auto childCost = [&](int32_t child) {
+				const Node &childNode = m_Nodes[child];
+				float childCombined = Aabb::Union(childNode.Box, leafBox).HalfArea();
+				return childNode.IsLeaf()
+					? childCombined + inheritance
+					: childCombined - childNode.Box.HalfArea() + inheritance;
+			};
+
+			float cost1 = childCost(node.Child1);
+			float cost2 = childCost(node.Child2);
+
+			if (cost < cost1 && cost < cost2)
+			{
+				break;
+			}
+			index = cost1 < cost2 ? node.Child1 : node.Child2;
+		}
+
+		int32_t sibling = index;
+		int32_t oldParent = m_Nodes[sibling].Parent;
+		int32_t newParent = AllocateNode();
+
+		m_Nodes[newParent].Parent = oldParent;
+		m_Nodes[newParent].Box = Aabb::Union(leafBox, m_Nodes[sibling].Box);
+		m_Nodes[newParent].Height = m_Nodes[sibling].Height + 1;
+		m_Nodes[newParent].Child1 = sibling;
+		m_Nodes[newParent].Child2 = leaf;
+
+		if (oldParent != k_Null)
+		{
+			ReplaceChild(oldParent, sibling, newParent);
+		}
+		else
+		{
+			m_Root = newParent;
+		}
+		m_Nodes[sibling].Parent = newParent;
+		m_Nodes[leaf].Parent = newParent;
+
+		Refit(newParent);
+	}
+
+	void RemoveLeaf(int32_t leaf)
+	{
+		if (leaf == m_Root)
+		{
+			m_Root = k_Null;
+			return;
+		}
+
+		int32_t parent = m_Nodes[leaf].Parent;
+		int32_t grandParent = m_Nodes[parent].Parent;
+		int32_t sibling = m_Nodes[parent].Child1 == leaf ? m_Nodes[parent].Child2 : m_Nodes[parent].Child1;
+
+		// The sibling takes the parent's place.
+		m_Nodes[sibling].Parent = grandParent;
+		if (grandParent != k_Null)
+		{
+			ReplaceChild(grandParent, parent, sibling);
+			FreeNode(parent);
+			Refit(grandParent);
+		}
+		else
+		{
+			m_Root = sibling;
+			FreeNode(parent);
+		}
+	}
+
+	void ReplaceChild(int32_t parent, int32_t oldChild, int32_t newChild)
+	{
+		if (m_Nodes[parent].Child1 == oldChild)
+		{
+			m_Nodes[parent].Child1 = newChild;
+		}
+		else
+		{
+			m_Nodes[parent].Child2 = newChild;
+		}
+	}
+
+	// Rebalances and recomputes boxes and heights from 'index' up to the root.
+	void Refit(int32_t index)
+	{
+		while (index != k_Null)
+		{
+			index = Balance(index);
+
+			Node &node = m_Nodes[index];
+			const Node &child1 = m_Nodes[node.Child1];
+			const Node &child2 = m_Nodes[node.Child2];
+			node.Height = 1 + std::max(child1.Height, child2.Height);
+			node.Box = Aabb::Union(child1.Box, child2.Box);
+
+			index = node.Parent;
+		}
+	}
+
+	// Rotates the taller child of 'a' above it if the children's heights differ by more than one,
+	// returning the index of the node now in a's place.
+	int32_t Balance(int32_t a)
+	{
+		Node &nodeA = m_Nodes[a];
+		if (nodeA.IsLeaf() || nodeA.Height < 2)
+		{
+			return a;
+		}
+
+		int32_t b = nodeA.Child1;
+		int32_t c = nodeA.Child2;
+		int32_t balance = m_Nodes[c].Height - m_Nodes[b].Height;
+
+		if (balance > 1)
+		{
+			return Rotate(a, c, b, false);
+		}
+		if (balance < -1)
+		{
+			return Rotate(a, b, c, true);
+		}
+		return a;
+	}
+
+	// Promotes 'up', a child of 'a', to a's place. 'a' keeps 'other' and takes the shorter of
+	// up's children, 'up' keeps the taller one. 'upIsChild1' says which child of 'a' 'up' was.
+	int32_t Rotate(int32_t a, int32_t up, int32_t other, bool upIsChild1)
+	{
+		Node &nodeA = m_Nodes[a];
+		Node &nodeUp = m_Nodes[up];
+
+		int32_t f = nodeUp.Child1;
+		int32_t g = nodeUp.Child2;
+
+		nodeUp.Child1 = a;
+		nodeUp.Parent = nodeA.Parent;
+		nodeA.Parent = up;
+
+		if (nodeUp.Parent != k_Null)
+		{
+			ReplaceChild(nodeUp.Parent, a, up);
+		}
+		else
+		{
+			m_Root = up;
+		}
+
+		int32_t taller = m_Nodes[f].Height > m_Nodes[g].Height ? f : g;
+		int32_t shorter = taller == f ? g : f;
+
+		nodeUp.Child2 = taller;
+		if (upIsChild1)
+		{
+			nodeA.Child1 = shorter;
+		}
+		else
+		{
+			nodeA.Child2 = shorter;
+		}
+		m_Nodes[shorter].Parent = a;
+
+		nodeA.Box = Aabb::Union(m_Nodes[other].Box, m_Nodes[shorter].Box);
+		nodeA.Height = 1 + std::max(m_Nodes[other].Height, m_Nodes[shorter].Height);
+		nodeUp.Box = Aabb::Union(nodeA.Box, m_Nodes[taller].Box);
+		nodeUp.Height = 1 + std::max(nodeA.Height, m_Nodes[taller].Height);
+
+		return up;
+	}
+
+private:
+	std::vector<Node> m_Nodes;
+	int32_t m_Root;
+	int32_t m_FreeList;
+	size_t m_LeafCount;
+	float m_Margin;
+};
@@ -1,128 +1,245 @@
-#pragma once
-
-#include <array>
-
-#include <glm/glm.hpp>
-#include <glm/ext.hpp>
-#include <glm/gtx/euler_angles.hpp>
-
-std::array<glm::vec3, 4> MakeQuadVertices(glm::vec3 position, glm::vec3 scale, glm::vec3 rotation)
-{
-	glm::mat4 rot =
-		glm::translate(glm::mat4(1.0f), position)
-		* glm::eulerAngleYXZ(rotation.y, rotation.x, rotation.z)
-		* glm::translate(glm::mat4(1.0f), -position);
-
-	glm::vec3 p1;
-	p1.x = position.x - scale.x;
-	p1.y = position.y - scale.y;
-	p1.z = position.z;
-	p1 = rot * glm::vec4(p1, 1.0f);
-
-	glm::vec3 p2;
-	p2.x = position.x - scale.x;
-	p2.y = position.y + scale.y;
-	p2.z = position.z;
-	p2 = rot * glm::vec4(p2, 1.0f);
-
-	glm::vec3 p3;
-	p3.x = position.x + scale.x;
-	p3.y = position.y - scale.y;
-	p3.z = position.z;
-	p3 = rot * glm::vec4(p3, 1.0f);
-	
-	glm::vec3 p4;
-	p4.x = position.x + scale.x;
-	p4.y = position.y + scale.y;
-	p4.z = position.z;
-	p4 = rot * glm::vec4(p4, 1.0f);
-
-	return { p1, p2, p3, p4 };
-}
-
-std::array<glm::vec3, 4> MakeQuadVertices(glm::mat4 transform)
-{
-	glm::vec3 p1;
-	p1.x = -1.0f;
-	p1.y = -1.0f;
-	p1.z = 0.0f;
-	p1 = transform * glm::vec4(p1, 1.0f);
-
-	glm::vec3 p2;
-	p2.x = -1.0f;
-	p2.y = 1.0f;
-	p2.z = 0.0f;
-	p2 = transform * glm::vec4(p2, 1.0f);
-
-	glm::vec3 p3;
-	p3.x = 1.0f;
-	p3.y = -1.0f;
-	p3.z = 0.0f;
-	p3 = transform * glm::vec4(p3, 1.0f);
-	
-	glm::vec3 p4;
-	p4.x = 1.0f;
-	p4.y = 1.0f;
-	p4.z = 0.0f;
-	p4 = transform * glm::vec4(p4, 1.0f);
-
-	return { p1, p2, p3, p4 };
-}
-
-std::array<glm::vec3, 8> MakeCubeVertices(glm::vec3 position, glm::vec3 scale, glm::vec3 rotation)
-{
-	glm::mat4 rot =
-		glm::translate(glm::mat4(1.0f), position)
-		* glm::eulerAngleYXZ(rotation.y, rotation.x, rotation.z)
-		* glm::translate(glm::mat4(1.0f), -position);
-
-	glm::vec3 p1;
-	p1.x = position.x - scale.x;
-	p1.y = position.y - scale.y;
-	p1.z = position.z + scale.z;
-	p1 = rot * glm::vec4(p1, 1.0f);
-
-	glm::vec3 p2;
-	p2.x = position.x - scale.x;
-	p2.y = position.y + scale.y;
-	p2.z = position.z + scale.z;
-	p2 = rot * glm::vec4(p2, 1.0f);
-
-	glm::vec3 p3;
-	p3.x = position.x + scale.x;
-	p3.y = position.y - scale.y;
-	p3.z = position.z + scale.z;
-	p3 = rot * glm::vec4(p3, 1.0f);
-	
-	glm::vec3 p4;
-	p4.x = position.x + scale.x;
-	p4.y = position.y + scale.y;
-	p4.z = position.z + scale.z;
-	p4 = rot * glm::vec4(p4, 1.0f);
-	
-	glm::vec3 p5;
-	p5.x = position.x - scale.x;
-	p5.y = position.y - scale.y;
-	p5.z = position.z - scale.z;
-	p5 = rot * glm::vec4(p5, 1.0f);
-
-	glm::vec3 p6;
-	p6.x = position.x - scale.x;
-	p6.y = position.y + scale.y;
-	p6.z = position.z - scale.z;
-	p6 = rot * glm::vec4(p6, 1.0f);
-
-	glm::vec3 p7;
-	p7.x = position.x + scale.x;
-	p7.y = position.y - scale.y;
-	p7.z = position.z - scale.z;
-	p7 = rot * glm::vec4(p7, 1.0f);
-	
-	glm::vec3 p8;
-	p8.x = position.x + scale.x;
-	p8.y = position.y + scale.y;
-	p8.z = position.z - scale.z;
-	p8 = rot * glm::vec4(p8, 1.0f);
-
-	return { p1, p2, p3, p4, p5, p6, p7, p8 };
+#pragma once
+
+#include "maths/Simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <glm/gtx/euler_angles.hpp>
+
+// Columns of rotation * scale, the half extents of a unit quad or cube once transformed.
+struct TransformAxes
+{
+	glm::vec3 X, Y, Z;
+};
+
+inline TransformAxes MakeAxes(glm::vec3 scale, glm::vec3 rotation)
+{
+	glm::mat3 rot(glm::eulerAngleYXZ(rotation.y, rotation.x, rotation.z));
+	return { rot[0] * scale.x, rot[1] * scale.y, rot[2] * scale.z };
+}
+
+inline std::array<glm::vec3, 4> MakeQuadVertices(glm::vec3 position, const TransformAxes &axes)
+{
+	return {
+		position - axes.X - axes.Y,
+		position - axes.X + axes.Y,
+		position + axes.X - axes.Y,
+		position + axes.X + axes.Y
+	};
+}
+
+inline std::array<glm::vec3, 8> MakeCubeVertices(glm::vec3 position, const TransformAxes &axes)
+{
+	glm::vec3 front = position + axes.Z;
+	glm::vec3 back = position - axes.Z;
+
+	return {
+		front - axes.X - axes.Y,
+		front - axes.X + axes.Y,
+		front + axes.X - axes.Y,
+		front + axes.X + axes.Y,
+		back - axes.X - axes.Y,
+		back - axes.X + axes.Y,
+		back + axes.X - axes.Y,
+		back + axes.X + axes.Y
+	};
+}
+
+inline std::array<glm::vec3, 4> MakeQuadVertices(glm::vec3 position, glm::vec3 scale, glm::vec3 rotation)
+{
+	return MakeQuadVertices(position, MakeAxes(scale, rotation));
+}
+
+inline std::array<glm::vec3, 4> MakeQuadVertices(const glm::mat4 &transform)
+{
+	TransformAxes axes{ glm::vec3(transform[0]), glm::vec3(transform[1]), glm::vec3(transform[2]) };
+	return MakeQuadVertices(glm::vec3(transform[3]), axes);
+}
+
+inline std::array<glm::vec3, 8> MakeCubeVertices(glm::vec3 position, glm::vec3 scale, glm::vec3 rotation)
+{
+	return MakeCubeVertices(position, MakeAxes(scale, rotation));
+}
+
+#if SIMD_SSE
+// Sine and cosine of every lane. Reduces to [-pi/4, pi/4] around the nearest even octant and
+// evaluates the Cephes single precision polynomials, within a few ulp for the angles we use.
+template<typename S>
+inline void SinCos(typename S::Reg x, typename S::Reg &sin, typename S::Reg &cos)
+{
+	using Reg = typename S::Reg;
+
+	const Reg signMask = S::Set(-0.0f);
+	const Reg one = S::Set(1.0f);
+	const Reg two = S::Set(2.0f);
+
+	Reg sign = S::And(x, signMask);
+	Reg ax = S::AndNot(signMask, x);
+
+	// Even octant 'j' and its quadrant in [0, 4), all kept as floats.
+	Reg j = S::Mul(S::Truncate(S::Mul(S::Add(S::Mul(ax, S::Set(1.27323954473516f)), one), S::Set(0.5f))), two);
+	Reg quadrant = S::Mul(j, S::Set(0.5f));
+	quadrant = S::Sub(quadrant, S::Mul(S::Truncate(S::Mul(quadrant, S::Set(0.25f))), S::Set(4.0f)));
+
+	// Extended precision ax - j * pi / 4.
+	Reg z = S::Sub(ax, S::Mul(j, S::Set(0.78515625f)));
+	z = S::Sub(z, S::Mul(j, S::Set(2.4187564849853515625e-4f)));
+	z = S::Sub(z, S::Mul(j, S::Set(3.77489497744594108e-8f)));
+	Reg zz = S::Mul(z, z);
+
+	Reg polyCos = S::Add(S::Mul(S::Set(2.443315711809948e-5f), zz), S::Set(-1.388731625493765e-3f));
+	polyCos = S::Add(S::Mul(polyCos, zz), S::Set(4.166664568298827e-2f));
+	polyCos = S::Mul(S::Mul(polyCos, zz), zz);
+	polyCos = S::Add(S::Sub(polyCos, S::Mul(zz, S::Set(0.5f))), one);
+
+	Reg polySin = S::Add(S::Mul(S::Set(-1.9515295891e-4f), zz), S::Set(8.3321608736e-3f));
+	polySin = S::Add(S::Mul(polySin, zz), S::Set(-1.6666654611e-1f));
+	polySin = S::Add(S::Mul(S::Mul(polySin, zz), z), z);
+
+	// Odd quadrants swap the polynomials, the sign follows the quadrant and, for sine, x.
+	Reg odd = S::CmpEq(S::Sub(quadrant, S::Mul(S::Truncate(S::Mul(quadrant, S::Set(0.5f))), two)), one);
+	Reg sinNegative = S::CmpGe(quadrant, two);
+	Reg cosNegative = S::Or(S::CmpEq(quadrant, one), S::CmpEq(quadrant, two));
+
+	sin = S::Xor(S::Select(odd, polyCos, polySin), S::Xor(sign, S::And(sinNegative, signMask)));
+	cos = S::Xor(S::Select(odd, polySin, polyCos), S::And(cosNegative, signMask));
+}
+
+// Computes the axes of 'S::Width' transforms at once. Inputs are gathered into lanes, the
+// rotation is built from the sines and cosines exactly as 'glm::eulerAngleYXZ' does.
+template<typename S>
+inline void MakeAxes(const glm::vec3 *scales, const glm::vec3 *rotations, TransformAxes *out)
+{
+	using Reg = typename S::Reg;
+	constexpr size_t W = S::Width;
+
+	alignas(32) float lanes[6][W];
+	for (size_t lane = 0; lane < W; ++lane)
+	{
+		lanes[0][lane] = rotations[lane].x;
+		lanes[1][lane] = rotations[lane].y;
+		lanes[2][lane] = rotations[lane].z;
+		lanes[3][lane] = scales[lane].x;
+		lanes[4][lane] = scales[lane].y;
+		lanes[5][lane] = scales[lane].z;
+	}
+
+	Reg sp, cp, sh, ch, sb, cb;
+	SinCos<S>(S::Load(lanes[0]), sp, cp);
+	SinCos<S>(S::Load(lanes[1]), sh, ch);
+	SinCos<S>(S::Load(lanes[2]), sb, cb);
+
+	Reg sx = S::Load(lanes[3]);
+	Reg sy = S::Load(lanes[4]);
+	Reg sz = S::Load(lanes[5]);
+
+	Reg spsb = S::Mul(sp, sb);
+	Reg spcb = S::Mul(sp, cb);
+
+	alignas(32) float axes[9][W];
+	S::Store(axes[0], S::Mul(S::Add(S::Mul(ch, cb), S::Mul(sh, spsb)), sx));
+	S::Store(axes[1], S::Mul(S::Mul(sb, cp), sx));
+	S::Store(axes[2], S::Mul(S::Sub(S::Mul(ch, spsb), S::Mul(sh, cb)), sx));
+	S::Store(axes[3], S::Mul(S::Sub(S::Mul(sh, spcb), S::Mul(ch, sb)), sy));
+	S::Store(axes[4], S::Mul(S::Mul(cb, cp), sy));
+	S::Store(axes[5], S::Mul(S::Add(S::Mul(sb, sh), S::Mul(ch, spcb)), sy));
+	S::Store(axes[6], S::Mul(S::Mul(sh, cp), sz));
+	S::Store(axes[7], S::Mul(S::Sub(S::Set(0.0f), sp), sz));
+	S::Store(axes[8], S::Mul(S::Mul(ch, cp), sz));
+
+	for (size_t lane = 0; lane < W; ++lane)
+	{
+		out[lane].X = { axes[0][lane], axes[1][lane], axes[2][lane] };
+		out[lane].Y = { axes[3][lane], axes[4][lane], axes[5][lane] };
+		out[lane].Z = { axes[6][lane], axes[7][lane], axes[8][lane] };
+	}
+}
+#endif
+
+// Axes of 'count' transforms, as wide as the target allows with a scalar tail.
+inline void MakeAxes(const glm::vec3 *scales, const glm::vec3 *rotations, size_t count, TransformAxes *out)
+{
+	size_t i = 0;
+
+#if SIMD_AVX
+	for (; i + SimdAvx::Width <= count; i += SimdAvx::Width)
+	{
+		MakeAxes<SimdAvx>(scales + i, rotations + i, out + i);
+	}
+#endif
+
+#if SIMD_SSE
+	for (; i + SimdSse::Width <= count; i += SimdSse::Width)
+	{
+		MakeAxes<SimdSse>(scales + i, rotations + i, out + i);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		out[i] = MakeAxes(scales[i], rotations[i]);
+	}
+}
+
+// Batch variants, writing the 4 or 8 corners of each of 'count' entities contiguously to 'out'.
+// Axes are computed in blocks so the scratch stays on the stack and in cache.
+inline void MakeQuadVertices(const glm::vec3 *positions, const glm::vec3 *scales, const glm::vec3 *rotations, size_t count, glm::vec3 *out)
+{
+	constexpr size_t k_Block = 64;
+	TransformAxes axes[k_Block];
+
+	for (size_t begin = 0; begin < count; begin += k_Block)
+	{
+		size_t size = std::min(k_Block, count - begin);
+		MakeAxes(scales + begin, rotations + begin, size, axes);
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			auto vertices = MakeQuadVertices(positions[begin + i], axes[i]);
+			std::copy(vertices.begin(), vertices.end(), out + (begin + i) * vertices.size());
+		}
+	}
+}
+
+inline void MakeCubeVertices(const glm::vec3 *positions, const glm::vec3 *scales, const glm::vec3 *rotations, size_t count, glm::vec3 *out)
+{
+	constexpr size_t k_Block = 64;
+	TransformAxes axes[k_Block];
+
+	for (size_t begin = 0; begin < count; begin += k_Block)
+	{
+		size_t size = std::min(k_Block, count - begin);
+		MakeAxes(scales + begin, rotations + begin, size, axes);
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			auto vertices = MakeCubeVertices(positions[begin + i], axes[i]);
+			std::copy(vertices.begin(), vertices.end(), out + (begin + i) * vertices.size());
+		}
+	}
+}
+
+// Transform of a unit quad or cube, matching the vertices 'MakeQuadVertices' and 'MakeCubeVertices' produce.
+inline glm::mat4 MakeTransform(glm::vec3 position, glm::vec3 scale, glm::vec3 rotation)
+{
+	return glm::translate(glm::mat4(1.0f), position)
+		* glm::eulerAngleYXZ(rotation.y, rotation.x, rotation.z)
+		* glm::scale(glm::mat4(1.0f), scale);
+}
+
+// Transform of a unit quad at 'position' which faces 'eye'.
+inline glm::mat4 MakeBillboard(glm::vec3 position, glm::vec3 scale, glm::vec3 eye)
+{
+	glm::vec3 forward = glm::normalize(position - eye);
+	glm::vec3 right = glm::normalize(glm::cross(glm::vec3{0.0f, 1.0f, 0.0f}, forward));
+	glm::vec3 up = glm::cross(forward, right);
+
+	return glm::mat4(
+		glm::vec4(right, 0), glm::vec4(up, 0),
+		glm::vec4(forward, 0), glm::vec4(position, 1)
+	) * glm::scale(glm::mat4(1.0f), scale);
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "maths/Aabb.hpp"
+#include "maths/Simd.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//-------------------------------------------------------------------------------------------------
+//	Frustum
+//
+//	Six planes extracted from a view projection matrix, each stored as (normal, distance) with the
+//	normal pointing into the frustum. Bounding spheres are tested conservatively, so a sphere which
+//	lies outside near a corner may still be reported as visible.
+//-------------------------------------------------------------------------------------------------
+class Frustum
+{
+public:
+	enum Plane
+	{
+		Left, Right, Bottom, Top, Near, Far,
+		PlaneCount
+	};
+
+	explicit Frustum(const glm::mat4 &viewProj)
+	{
+		auto row = [&](int i) {
+			return glm::vec4{ viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i] };
+		};
+
+		m_Planes[Left] = row(3) + row(0);
+		m_Planes[Right] = row(3) - row(0);
+		m_Planes[Bottom] = row(3) + row(1);
+		m_Planes[Top] = row(3) - row(1);
+		m_Planes[Near] = row(3) + row(2);
+		m_Planes[Far] = row(3) - row(2);
+
+		for (auto &plane : m_Planes)
+		{
+			plane = plane * (1.0f / glm::length(glm::vec3(plane)));
+		}
+	}
+
+	const std::array<glm::vec4, PlaneCount> &GetPlanes() const { return m_Planes; }
+
+	bool Intersects(glm::vec3 centre, float radius) const
+	{
+		for (const auto &plane : m_Planes)
+		{
+			if (glm::dot(glm::vec3(plane), centre) + plane.w < -radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Intersects(const Aabb &aabb) const
+	{
+		// Only the corner furthest along each plane's normal needs testing.
+		for (const auto &plane : m_Planes)
+		{
+			glm::vec3 corner{
+				plane.x >= 0.0f ? aabb.Max.x : aabb.Min.x,
+				plane.y >= 0.0f ? aabb.Max.y : aabb.Min.y,
+				plane.z >= 0.0f ? aabb.Max.z : aabb.Min.z
+			};
+			if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Tests 'count' spheres given as separate coordinate and radius streams, writing 1 to
+	// 'visible' for each one intersecting the frustum and 0 otherwise.
+	void Intersects(const float *x, const float *y, const float *z, const float *radius, size_t count, uint8_t *visible) const
+	{
+		size_t i = 0;
+
+#if SIMD_SSE
+		__m128 planes[PlaneCount][4];
+		for (size_t p = 0; p < PlaneCount; ++p)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				planes[p][c] = _mm_set1_ps(m_Planes[p][c]);
+			}
+		}
+
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x4 = _mm_loadu_ps(x + i);
+			__m128 y4 = _mm_loadu_ps(y + i);
+			__m128 z4 = _mm_loadu_ps(z + i);
+			__m128 negRadius = _mm_sub_ps(zero, _mm_loadu_ps(radius + i));
+
+			__m128 inside = _mm_cmpeq_ps(zero, zero);
+			for (const auto &plane : planes)
+			{
+				__m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(plane[0], x4), _mm_mul_ps(plane[1], y4)),
+					_mm_add_ps(_mm_mul_ps(plane[2], z4), plane[3])
+				);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			visible[i + 0] = static_cast<uint8_t>(mask & 1);
+			visible[i + 1] = static_cast<uint8_t>((mask >> 1) & 1);
+			visible[i + 2] = static_cast<uint8_t>((mask >> 2) & 1);
+			visible[i + 3] = static_cast<uint8_t>((mask >> 3) & 1);
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			visible[i] = Intersects(glm::vec3{ x[i], y[i], z[i] }, radius[i]) ? 1 : 0;
+		}
+	}
+
+private:
+	std::array<glm::vec4, PlaneCount> m_Planes;
+};
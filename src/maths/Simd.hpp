@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Config.h"
+
+#include <cstddef>
+
+//-------------------------------------------------------------------------------------------------
+//	SIMD
+//
+//	SIMD_SSE / SIMD_AVX are set when the target supports the instruction set and 'ENABLE_SIMD' is
+//	on. Kernels using them must always keep a scalar path for the remaining elements.
+//-------------------------------------------------------------------------------------------------
+#if ENABLE_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SIMD_SSE 1
+#else
+#define SIMD_SSE 0
+#endif
+
+#if SIMD_SSE && defined(__AVX__)
+#define SIMD_AVX 1
+#else
+#define SIMD_AVX 0
+#endif
+
+#if SIMD_SSE
+#include <immintrin.h>
+#endif
+
+//-------------------------------------------------------------------------------------------------
+//	SimdSse / SimdAvx
+//
+//	Thin wrappers over one register width, so a kernel written once as a template over the wrapper
+//	runs 4 or 8 lanes wide. Only uses AVX1, so no 256 bit integer operations.
+//-------------------------------------------------------------------------------------------------
+#if SIMD_SSE
+struct SimdSse
+{
+	using Reg = __m128;
+	static constexpr size_t Width = 4;
+
+	static Reg Set(float value) { return _mm_set1_ps(value); }
+	static Reg Load(const float *data) { return _mm_load_ps(data); }
+	static void Store(float *data, Reg a) { _mm_store_ps(data, a); }
+
+	static Reg Add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+	static Reg Sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+	static Reg Mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+
+	static Reg And(Reg a, Reg b) { return _mm_and_ps(a, b); }
+	static Reg AndNot(Reg a, Reg b) { return _mm_andnot_ps(a, b); }
+	static Reg Or(Reg a, Reg b) { return _mm_or_ps(a, b); }
+	static Reg Xor(Reg a, Reg b) { return _mm_xor_ps(a, b); }
+
+	static Reg CmpEq(Reg a, Reg b) { return _mm_cmpeq_ps(a, b); }
+	static Reg CmpGe(Reg a, Reg b) { return _mm_cmpge_ps(a, b); }
+	// Lanes of 'mask' set pick 'a', others 'b'.
+	static Reg Select(Reg mask, Reg a, Reg b) { return Or(And(mask, a), AndNot(mask, b)); }
+	static Reg Truncate(Reg a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+};
+#endif
+
+#if SIMD_AVX
+struct SimdAvx
+{
+	using Reg = __m256;
+	static constexpr size_t Width = 8;
+
+	static Reg Set(float value) { return _mm256_set1_ps(value); }
+	static Reg Load(const float *data) { return _mm256_load_ps(data); }
+	static void Store(float *data, Reg a) { _mm256_store_ps(data, a); }
+
+	static Reg Add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+	static Reg Sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+	static Reg Mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+
+	static Reg And(Reg a, Reg b) { return _mm256_and_ps(a, b); }
+	static Reg AndNot(Reg a, Reg b) { return _mm256_andnot_ps(a, b); }
+	static Reg Or(Reg a, Reg b) { return _mm256_or_ps(a, b); }
+	static Reg Xor(Reg a, Reg b) { return _mm256_xor_ps(a, b); }
+
+	static Reg CmpEq(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	static Reg CmpGe(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	// Lanes of 'mask' set pick 'a', others 'b'.
+	static Reg Select(Reg mask, Reg a, Reg b) { return _mm256_blendv_ps(b, a, mask); }
+	static Reg Truncate(Reg a) { return _mm256_cvtepi32_ps(_mm256_cvttps_epi32(a)); }
+};
+#endif
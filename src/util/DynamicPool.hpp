@@ -1,62 +1,222 @@
-#pragma once
-
-#include <cstdint>
-#include <cstring>
-#include <type_traits>
-
-class DynamicPool
-{
-public:
-	DynamicPool()
-	: m_Data(nullptr)
-	, m_Size(0)
-	{
-	}
-
-	~DynamicPool()
-	{
-		delete[] m_Data;
-	}
-
-	DynamicPool(const DynamicPool &other) = delete;
-	DynamicPool(const DynamicPool &&other) = delete;
-	DynamicPool& operator=(DynamicPool &other) = delete;
-	DynamicPool& operator=(DynamicPool &&other) = delete;
-
-	template<typename T>
-	T &Get(size_t index)
-	{
-		static_assert(
-			std::is_trivially_copyable_v<T>,
-			"Only supports trivially copyable types !"
-		);
-
-		if (m_Size <= index)
-		{
-			size_t newSize = m_Size;
-
-			while (index >= newSize)
-			{
-				newSize = newSize == 0 ? 1 : newSize * 2;
-			}
-
-			size_t oldSize = m_Size * sizeof(T);
-			uint8_t *oldData = new uint8_t[oldSize]; 
-			memcpy(oldData, m_Data, oldSize);
-
-			delete[] m_Data;
-
-			m_Size = newSize;
-			m_Data = new uint8_t[newSize * sizeof(T)];
-			memcpy(m_Data, oldData, oldSize);
-
-			delete[] oldData;
-		}
-
-		return *reinterpret_cast<T*>(m_Data + (index * sizeof(T)));
-	}
-
-private:
-	uint8_t *m_Data;
-	size_t m_Size;
-};
\ No newline at end of file
+#pragma once
+
+#include "util/Log.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+//	DynamicPool
+//
+//	Growable pool of fixed size elements. By default elements are stored contiguously and grow
+//	geometrically with a single realloc. A paged pool instead allocates zeroed pages of
+//	'pageSize' elements on demand, so growth never moves existing elements and references stay
+//	valid. Running out of memory throws std::bad_alloc, as the standard containers do.
+//-------------------------------------------------------------------------------------------------
+class DynamicPool
+{
+public:
+	explicit DynamicPool(size_t stride = 0, size_t pageSize = 0)
+	: m_Data(nullptr)
+	, m_Capacity(0)
+	, m_Stride(stride)
+	, m_PageShift(0)
+	{
+		if (pageSize > 0)
+		{
+			ASSERT((pageSize & (pageSize - 1)) == 0, "Page size must be a power of two !");
+			while ((size_t(1) << m_PageShift) < pageSize)
+			{
+				++m_PageShift;
+			}
+		}
+		m_Paged = pageSize > 0;
+	}
+
+	~DynamicPool()
+	{
+		Free();
+	}
+
+	DynamicPool(const DynamicPool &other) = delete;
+	DynamicPool& operator=(const DynamicPool &other) = delete;
+
+	DynamicPool(DynamicPool &&other) noexcept
+	{
+		MoveFrom(other);
+	}
+
+	DynamicPool& operator=(DynamicPool &&other) noexcept
+	{
+		if (this != &other)
+		{
+			Free();
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
+	template<typename T>
+	T &Get(size_t index)
+	{
+		static_assert(
+			std::is_trivially_copyable_v<T>,
+			"Only supports trivially copyable types !"
+		);
+		ASSERT(sizeof(T) == m_Stride, "Pool accessed with a type of the wrong size !");
+
+		return *reinterpret_cast<T*>(Get(index));
+	}
+
+	// Returns the element at 'index', growing the pool to hold it if necessary.
+	uint8_t *Get(size_t index)
+	{
+		if (m_Paged)
+		{
+			size_t page = index >> m_PageShift;
+			if (page >= m_Pages.size() || !m_Pages[page])
+			{
+				AllocatePage(page);
+			}
+		}
+		else if (index >= m_Capacity)
+		{
+			size_t newCapacity = m_Capacity == 0 ? 1 : m_Capacity;
+			while (index >= newCapacity)
+			{
+				newCapacity *= 2;
+			}
+			Reallocate(newCapacity);
+		}
+
+		return At(index);
+	}
+
+	// Returns the element at 'index' without growing the pool.
+	uint8_t *At(size_t index)
+	{
+		if (m_Paged)
+		{
+			size_t mask = (size_t(1) << m_PageShift) - 1;
+			return m_Pages[index >> m_PageShift] + (index & mask) * m_Stride;
+		}
+		return m_Data + index * m_Stride;
+	}
+
+	// Returns the element at 'index' or nullptr if its page has not been allocated.
+	uint8_t *Find(size_t index)
+	{
+		if (m_Paged)
+		{
+			size_t page = index >> m_PageShift;
+			return page < m_Pages.size() && m_Pages[page] ? At(index) : nullptr;
+		}
+		return index < m_Capacity ? At(index) : nullptr;
+	}
+
+	void Reserve(size_t count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		if (m_Paged)
+		{
+			size_t pages = ((count - 1) >> m_PageShift) + 1;
+			for (size_t page = 0; page < pages; ++page)
+			{
+				if (page >= m_Pages.size() || !m_Pages[page])
+				{
+					AllocatePage(page);
+				}
+			}
+		}
+		else if (count > m_Capacity)
+		{
+			Reallocate(count);
+		}
+	}
+
+	// Contiguous storage only, paged pools must be accessed element-wise.
+	uint8_t *Data()
+	{
+		ASSERT(!m_Paged, "Paged pools have no contiguous data !");
+		return m_Data;
+	}
+
+	size_t Capacity() const
+	{
+		return m_Paged ? m_Pages.size() << m_PageShift : m_Capacity;
+	}
+
+	size_t GetStride() const { return m_Stride; }
+	bool IsPaged() const { return m_Paged; }
+
+private:
+	// The old block is left untouched if this throws, so the pool stays usable at its old capacity.
+	void Reallocate(size_t capacity)
+	{
+		uint8_t *data = static_cast<uint8_t *>(std::realloc(m_Data, capacity * m_Stride));
+		if (!data)
+		{
+			LOG("Failed to grow pool to '%zu' elements !", capacity);
+			throw std::bad_alloc();
+		}
+		m_Data = data;
+		m_Capacity = capacity;
+	}
+
+	void AllocatePage(size_t page)
+	{
+		if (page >= m_Pages.size())
+		{
+			m_Pages.resize(page + 1, nullptr);
+		}
+		m_Pages[page] = static_cast<uint8_t *>(std::calloc(size_t(1) << m_PageShift, m_Stride));
+		if (!m_Pages[page])
+		{
+			LOG("Failed to allocate pool page '%zu' !", page);
+			throw std::bad_alloc();
+		}
+	}
+
+	void Free()
+	{
+		std::free(m_Data);
+		for (uint8_t *page : m_Pages)
+		{
+			std::free(page);
+		}
+		m_Data = nullptr;
+		m_Capacity = 0;
+		m_Pages.clear();
+	}
+
+	void MoveFrom(DynamicPool &other)
+	{
+		m_Data = other.m_Data;
+		m_Capacity = other.m_Capacity;
+		m_Stride = other.m_Stride;
+		m_Paged = other.m_Paged;
+		m_PageShift = other.m_PageShift;
+		m_Pages = std::move(other.m_Pages);
+
+		other.m_Data = nullptr;
+		other.m_Capacity = 0;
+		other.m_Pages.clear();
+	}
+
+private:
+	uint8_t *m_Data;
+	size_t m_Capacity;
+	size_t m_Stride;
+
+	bool m_Paged;
+	size_t m_PageShift;
+	std::vector<uint8_t *> m_Pages;
+};
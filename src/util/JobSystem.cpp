@@ -0,0 +1,216 @@
+#include "JobSystem.hpp"
+
+#include "util/Log.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct JobEntry
+{
+	JobSystem::Job Func;
+	JobCounter *Counter;
+};
+
+struct JobQueue
+{
+	std::mutex Mutex;
+	std::deque<JobEntry> Jobs;
+};
+
+struct JobSystemData
+{
+	std::vector<std::unique_ptr<JobQueue>> Queues;
+	std::vector<std::thread> Workers;
+
+	std::mutex SleepMutex;
+	std::condition_variable SleepCondition;
+	std::atomic<size_t> QueuedJobs{ 0 };
+	std::atomic<size_t> NextQueue{ 0 };
+	std::atomic<bool> Running{ false };
+};
+
+static JobSystemData s_JobSystemData;
+static thread_local size_t s_ThreadIndex = 0;
+
+void JobSystem::Init(size_t workers)
+{
+	if (workers == 0)
+	{
+		size_t hardware = std::thread::hardware_concurrency();
+		workers = hardware > 1 ? hardware - 1 : 0;
+	}
+	workers = std::min(workers, k_MaxThreads - 1);
+
+	s_JobSystemData.Running = true;
+	for (size_t i = 0; i < workers + 1; ++i)
+	{
+		s_JobSystemData.Queues.push_back(std::make_unique<JobQueue>());
+	}
+	for (size_t i = 0; i < workers; ++i)
+	{
+		s_JobSystemData.Workers.emplace_back(&JobSystem::WorkerMain, i + 1);
+	}
+
+	LOG("Job system started with '%zu' worker threads !", workers);
+}
+
+void JobSystem::Terminate()
+{
+	{
+		std::lock_guard<std::mutex> lock(s_JobSystemData.SleepMutex);
+		s_JobSystemData.Running = false;
+	}
+	s_JobSystemData.SleepCondition.notify_all();
+
+	for (auto &worker : s_JobSystemData.Workers)
+	{
+		worker.join();
+	}
+	s_JobSystemData.Workers.clear();
+	s_JobSystemData.Queues.clear();
+}
+
+size_t JobSystem::GetThreadCount()
+{
+	return s_JobSystemData.Workers.size() + 1;
+}
+
+size_t JobSystem::GetThreadIndex()
+{
+	return s_ThreadIndex;
+}
+
+void JobSystem::Dispatch(JobCounter &counter, Job job)
+{
+	counter.Pending++;
+
+	if (s_JobSystemData.Queues.empty())
+	{
+		job();
+		counter.Pending--;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(s_JobSystemData.SleepMutex);
+		s_JobSystemData.QueuedJobs++;
+	}
+
+	// Workers push onto their own queue, the main thread spreads jobs across all queues.
+	size_t queue = s_ThreadIndex != 0
+		? s_ThreadIndex
+		: s_JobSystemData.NextQueue++ % s_JobSystemData.Queues.size();
+	{
+		std::lock_guard<std::mutex> lock(s_JobSystemData.Queues[queue]->Mutex);
+		s_JobSystemData.Queues[queue]->Jobs.push_back({ std::move(job), &counter });
+	}
+	s_JobSystemData.SleepCondition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter &counter)
+{
+	while (counter.Pending > 0)
+	{
+		if (!RunPending())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::RunPending()
+{
+	return RunOne(s_ThreadIndex);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t begin, size_t end)> &func)
+{
+	if (count <= chunkSize || GetThreadCount() == 1)
+	{
+		func(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	for (size_t begin = 0; begin < count; begin += chunkSize)
+	{
+		size_t end = std::min(begin + chunkSize, count);
+		Dispatch(counter, [&func, begin, end]() { func(begin, end); });
+	}
+	Wait(counter);
+}
+
+bool JobSystem::RunOne(size_t thread)
+{
+	auto &queues = s_JobSystemData.Queues;
+	if (queues.empty())
+	{
+		return false;
+	}
+
+	JobEntry entry;
+	bool found = false;
+
+	// Own queue first, newest job first as it is most likely still in cache.
+	{
+		JobQueue &own = *queues[thread];
+		std::lock_guard<std::mutex> lock(own.Mutex);
+		if (!own.Jobs.empty())
+		{
+			entry = std::move(own.Jobs.back());
+			own.Jobs.pop_back();
+			found = true;
+		}
+	}
+
+	// Otherwise steal the oldest job from another queue.
+	for (size_t i = 1; !found && i < queues.size(); ++i)
+	{
+		JobQueue &victim = *queues[(thread + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.Mutex);
+		if (!victim.Jobs.empty())
+		{
+			entry = std::move(victim.Jobs.front());
+			victim.Jobs.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		return false;
+	}
+
+	s_JobSystemData.QueuedJobs--;
+	entry.Func();
+	entry.Counter->Pending--;
+	return true;
+}
+
+void JobSystem::WorkerMain(size_t thread)
+{
+	s_ThreadIndex = thread;
+
+	while (true)
+	{
+		if (RunOne(thread))
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(s_JobSystemData.SleepMutex);
+		s_JobSystemData.SleepCondition.wait(lock, []() {
+			return !s_JobSystemData.Running || s_JobSystemData.QueuedJobs > 0;
+		});
+
+		if (!s_JobSystemData.Running)
+		{
+			break;
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+//-------------------------------------------------------------------------------------------------
+//	JobSystem
+//
+//	Pool of worker threads, each with its own job queue. Workers pop their own queue LIFO and
+//	steal FIFO from the other queues when they run dry. Threads waiting on a counter execute
+//	jobs instead of blocking, so jobs may dispatch and wait on other jobs.
+//-------------------------------------------------------------------------------------------------
+struct JobCounter
+{
+	std::atomic<size_t> Pending{ 0 };
+};
+
+class JobSystem
+{
+public:
+	using Job = std::function<void()>;
+
+	// Upper bound of 'GetThreadCount', for per thread data which may be sized before 'Init'.
+	static constexpr size_t k_MaxThreads = 64;
+
+	// 'workers' defaults to one less than the number of hardware threads, both are capped so
+	// there are at most 'k_MaxThreads' threads.
+	static void Init(size_t workers = 0);
+	static void Terminate();
+
+	// Number of threads executing jobs, including the main thread.
+	static size_t GetThreadCount();
+	// Index of the calling thread in [0, GetThreadCount()), the main thread is always 0.
+	static size_t GetThreadIndex();
+
+	static void Dispatch(JobCounter &counter, Job job);
+	static void Wait(JobCounter &counter);
+	// Runs one queued job on the calling thread, returns false if there was none.
+	static bool RunPending();
+
+	// Splits [0, count) into chunks of at most 'chunkSize' and runs them across all threads.
+	static void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t begin, size_t end)> &func);
+
+private:
+	static bool RunOne(size_t thread);
+	static void WorkerMain(size_t thread);
+};
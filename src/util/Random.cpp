@@ -1,4 +1,51 @@
 #include "Random.hpp"
 
+#include "maths/Simd.hpp"
+
+#include <cstring>
+
 std::mt19937 Random::s_RandomGenerator;
-std::uniform_int_distribution<Random::DistType> Random::s_Distribution;
\ No newline at end of file
+std::uniform_int_distribution<Random::DistType> Random::s_Distribution;
+uint32_t Random::s_LaneState[4] = { 0x9E3779B9u, 0x7F4A7C15u, 0x85EBCA6Bu, 0xC2B2AE35u };
+
+// Steps a xorshift32 lane and maps its top 23 bits to a float in [1, 2).
+static inline float NextLane(uint32_t &state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	uint32_t bits = (state >> 9) | 0x3F800000u;
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+void Random::Floats(float *out, size_t count, float min, float max)
+{
+	float range = max - min;
+	float offset = min - range;
+	size_t i = 0;
+
+#if SIMD_SSE
+	__m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s_LaneState));
+	const __m128i one = _mm_set1_epi32(0x3F800000);
+	const __m128 range4 = _mm_set1_ps(range);
+	const __m128 offset4 = _mm_set1_ps(offset);
+	for (; i + 4 <= count; i += 4)
+	{
+		state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+		state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+		state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+
+		__m128 value = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(state, 9), one));
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(value, range4), offset4));
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(s_LaneState), state);
+#endif
+
+	for (; i < count; ++i)
+	{
+		out[i] = NextLane(s_LaneState[i & 3]) * range + offset;
+	}
+}
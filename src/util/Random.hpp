@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <random>
 #include <limits>
 
@@ -14,8 +16,17 @@ public:
 	static void Init()
 	{
 		s_RandomGenerator.seed(std::random_device()());
+		for (auto &lane : s_LaneState)
+		{
+			lane = GetFromDist() | 1u;
+		}
 	}
 
+	// Fills 'out' with 'count' uniform floats in [min, max). Draws come from independent
+	// xorshift lanes which are stepped four at a time, so this is much cheaper than 'Float' for
+	// large batches but is not suitable where statistical quality matters.
+	static void Floats(float *out, size_t count, float min, float max);
+
 	static bool Bool()
 	{
 		return Float<float>() < 0.5f;
@@ -72,4 +83,5 @@ private:
 private:
 	static std::mt19937 s_RandomGenerator;
 	static std::uniform_int_distribution<DistType> s_Distribution;
+	static uint32_t s_LaneState[4];
 };
\ No newline at end of file
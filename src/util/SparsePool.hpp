@@ -0,0 +1,103 @@
+#pragma once
+
+#include "util/DynamicPool.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+//	SparsePool
+//
+//	Sparse set of fixed size elements. The sparse table maps an id to its slot in the packed dense
+//	arrays, so iteration never walks holes and element storage scales with the number of
+//	elements rather than with the highest id. The sparse table itself is paged, so only ranges of
+//	ids that are actually used cost memory.
+//-------------------------------------------------------------------------------------------------
+class SparsePool
+{
+	static constexpr size_t k_SparsePageSize = 4 * 1024;
+
+public:
+	explicit SparsePool(size_t stride = 0)
+	: m_Sparse(sizeof(uint32_t), k_SparsePageSize)
+	, m_Data(stride)
+	{
+	}
+
+	bool Contains(uint32_t id)
+	{
+		return GetSlot(id) != 0;
+	}
+
+	uint8_t *Insert(uint32_t id)
+	{
+		// Slots are stored offset by one so that zeroed pages read as empty.
+		uint32_t &slot = m_Sparse.Get<uint32_t>(id);
+		if (slot == 0)
+		{
+			m_Dense.push_back(id);
+			slot = static_cast<uint32_t>(m_Dense.size());
+		}
+
+		return m_Data.Get(slot - 1);
+	}
+
+	void Remove(uint32_t id)
+	{
+		uint32_t slot = GetSlot(id);
+		if (slot == 0)
+		{
+			return;
+		}
+
+		uint32_t last = static_cast<uint32_t>(m_Dense.size());
+		if (slot != last)
+		{
+			memcpy(m_Data.At(slot - 1), m_Data.At(last - 1), m_Data.GetStride());
+			m_Dense[slot - 1] = m_Dense[last - 1];
+			m_Sparse.Get<uint32_t>(m_Dense[slot - 1]) = slot;
+		}
+
+		m_Dense.pop_back();
+		m_Sparse.Get<uint32_t>(id) = 0;
+	}
+
+	void Reserve(size_t count)
+	{
+		m_Dense.reserve(count);
+		m_Data.Reserve(count);
+	}
+
+	uint8_t *Get(uint32_t id)
+	{
+		return m_Data.At(*reinterpret_cast<uint32_t *>(m_Sparse.At(id)) - 1);
+	}
+
+	template<typename T>
+	T &Get(uint32_t id)
+	{
+		return *reinterpret_cast<T *>(Get(id));
+	}
+
+	template<typename T>
+	T *Data()
+	{
+		return reinterpret_cast<T *>(m_Data.Data());
+	}
+
+	size_t Size() const { return m_Dense.size(); }
+	const std::vector<uint32_t> &GetIds() const { return m_Dense; }
+
+private:
+	uint32_t GetSlot(uint32_t id)
+	{
+		uint8_t *slot = m_Sparse.Find(id);
+		return slot ? *reinterpret_cast<uint32_t *>(slot) : 0;
+	}
+
+private:
+	DynamicPool m_Sparse;
+	std::vector<uint32_t> m_Dense;
+	DynamicPool m_Data;
+};
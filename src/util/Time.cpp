@@ -1,9 +1,9 @@
-#include "Time.hpp"
-
-#define GLFW_INCLUDE_NONE
-#include <GLFW/glfw3.h>
-
-double Time::Seconds()
-{
-	return glfwGetTime();
+#include "Time.hpp"
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+double Time::Seconds()
+{
+	return glfwGetTime();
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
-#pragma once
-
-class Time
-{
-public:
-	static double Seconds();
+#pragma once
+
+class Time
+{
+public:
+	static double Seconds();
 };
\ No newline at end of file